@@ -0,0 +1,108 @@
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/Classify.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Reports the throughput of classifying a large array of keys against a read-only RangeMap:
+// a loop of 'operator[]', 'classify()' on the calling thread, and 'classify()' on a growing
+// number of threads. The keys are classified once in random order and once sorted.
+//
+// Usage: ClassifyBenchmark [keys] [ranges]
+
+
+using Map = RangeMap<std::uint64_t, std::uint32_t>;
+
+
+
+template<typename F>
+double Run( std::size_t count, F&& fn )
+{
+    const auto start { std::chrono::steady_clock::now() };
+    fn();
+    const double seconds { std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() };
+
+    return double( count ) / seconds / 1e6;
+}
+
+
+
+void Report( std::string const& name, double random, double sorted )
+{
+    std::cout << std::left  << std::setw(28) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << random
+              << std::setw(16) << sorted
+              << std::endl;
+}
+
+
+
+int main( int argc, char** argv )
+{
+    const std::size_t numKeys   { argc > 1 ? std::size_t( std::strtoull( argv[1], nullptr, 10 ) ) : 20'000'000 };
+    const std::size_t numRanges { argc > 2 ? std::size_t( std::strtoull( argv[2], nullptr, 10 ) ) : 1'000'000 };
+
+    const std::uint64_t keySpace { numRanges * 1'000 };
+
+    std::mt19937_64 gen { 42 };
+    std::uniform_int_distribution<std::uint64_t> distKey { 0, keySpace };
+    std::uniform_int_distribution<std::uint64_t> distLen { 1, 1'000 };
+    std::uniform_int_distribution<std::uint32_t> distVal { 1, 15 };
+
+    Map map { 0 };
+    for( std::size_t n{0}; n < numRanges; ++n )
+    {
+        const std::uint64_t keyBegin { distKey(gen) };
+        map.assign( keyBegin, keyBegin + distLen(gen), distVal(gen) );
+    }
+
+    std::vector<std::uint64_t> keys( numKeys );
+    for( auto& key : keys ) { key = distKey(gen); }
+
+    std::vector<std::uint64_t> sorted { keys };
+    std::sort( sorted.begin(), sorted.end() );
+
+    std::vector<std::uint32_t> out( numKeys );
+
+    std::cout << "million keys per second, " << numKeys << " keys, " << map.data().size() << " boundaries" << std::endl;
+    std::cout << std::left  << std::setw(28) << ""
+              << std::right << std::setw(16) << "random keys"
+              << std::setw(16) << "sorted keys"
+              << std::endl;
+
+    auto lookupLoop = [&]( std::vector<std::uint64_t> const& input )
+    {
+        return Run( numKeys, [&]{ for( std::size_t i{0}; i < numKeys; ++i ) { out[i] = map[input[i]]; } } );
+    };
+    Report( "operator[] loop", lookupLoop( keys ), lookupLoop( sorted ) );
+
+    auto singleThread = [&]( std::vector<std::uint64_t> const& input )
+    {
+        return Run( numKeys, [&]{ classify( map, input, out ); } );
+    };
+    Report( "classify, calling thread", singleThread( keys ), singleThread( sorted ) );
+
+    const unsigned maxThreads { std::max( 1u, std::thread::hardware_concurrency() ) };
+    for( unsigned numThreads{1}; numThreads <= maxThreads; numThreads *= 2 )
+    {
+        ThreadPool pool { numThreads - 1 };
+
+        auto parallel = [&]( std::vector<std::uint64_t> const& input )
+        {
+            return Run( numKeys, [&]{ classify( map, input, out, pool ); } );
+        };
+        Report( "classify, " + std::to_string( numThreads ) + (numThreads == 1 ? " thread" : " threads"), parallel( keys ), parallel( sorted ) );
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/ConcurrentRangeMap.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Reports the throughput of mixed 'assign()' and 'operator[]' traffic from a growing number of
+// threads, for ConcurrentRangeMap and for a RangeMap behind a reader-writer lock. The keys are
+// drawn from a few hot spots, so writers keep touching overlapping ranges. Without arguments it
+// reports mostly lookups and then assignments only, which shows how writers scale.
+//
+// Usage: ConcurrencyBenchmark [percentage of assignments] [milliseconds per run]
+
+
+class LockedRangeMap
+{
+  public:
+    LockedRangeMap( int defaultVal )
+    : mMap { defaultVal }
+    {}
+
+    void assign( std::uint32_t keyBegin, std::uint32_t keyEnd, int keyVal )
+    {
+        std::unique_lock lock { mMutex };
+        mMap.assign( keyBegin, keyEnd, keyVal );
+    }
+
+    int operator[]( std::uint32_t key ) const
+    {
+        std::shared_lock lock { mMutex };
+        return mMap[key];
+    }
+
+  private:
+    mutable std::shared_mutex    mMutex;
+    RangeMap<std::uint32_t, int> mMap;
+};
+
+
+
+template<typename Map>
+double Run( Map& map, unsigned numThreads, unsigned writePercent, std::chrono::milliseconds duration )
+{
+    std::atomic<bool>          stop { false };
+    std::atomic<std::uint64_t> ops  { 0 };
+
+    std::vector<std::thread> threads;
+    for( unsigned t{0}; t < numThreads; ++t )
+    {
+        threads.emplace_back( [&map, &stop, &ops, t, writePercent]()
+        {
+            std::mt19937 gen { t };
+            std::uniform_int_distribution<std::uint32_t> distHotSpot { 0, 7 };
+            std::uniform_int_distribution<std::uint32_t> distOffset  { 0, 100'000 };
+            std::uniform_int_distribution<std::uint32_t> distLen     { 1, 1'000 };
+            std::uniform_int_distribution<unsigned>      distOp      { 0, 99 };
+            std::uniform_int_distribution<int>           distVal     { 0, 7 };
+
+            std::uint64_t count { 0 };
+            while( !stop.load( std::memory_order_relaxed ) )
+            {
+                const std::uint32_t key { distHotSpot(gen) * 10'000'000 + distOffset(gen) };
+
+                if( distOp(gen) < writePercent )
+                {
+                    map.assign( key, key + distLen(gen), distVal(gen) );
+                }
+                else
+                {
+                    volatile int value { map[key] };
+                    (void)value;
+                }
+                ++count;
+            }
+            ops += count;
+        });
+    }
+
+    std::this_thread::sleep_for( duration );
+    stop = true;
+    for( auto& thread : threads ) { thread.join(); }
+
+    return double( ops ) / std::chrono::duration<double>( duration ).count();
+}
+
+
+
+void Report( unsigned writePercent, std::chrono::milliseconds duration )
+{
+    const unsigned maxThreads { std::max( 1u, std::thread::hardware_concurrency() ) };
+
+    std::cout << "million operations per second, " << writePercent << "% assignments" << std::endl;
+    std::cout << std::setw(8)  << "threads"
+              << std::setw(26) << "ConcurrentRangeMap"
+              << std::setw(26) << "RangeMap + shared_mutex"
+              << std::endl;
+
+    for( unsigned numThreads{1}; numThreads <= maxThreads; numThreads *= 2 )
+    {
+        ConcurrentRangeMap<std::uint32_t, int> concurrent { -1 };
+        LockedRangeMap                         locked     { -1 };
+
+        std::cout << std::setw(8)  << numThreads << std::fixed << std::setprecision(2)
+                  << std::setw(26) << Run( concurrent, numThreads, writePercent, duration ) / 1e6
+                  << std::setw(26) << Run( locked,     numThreads, writePercent, duration ) / 1e6
+                  << std::endl;
+    }
+}
+
+
+
+int main( int argc, char** argv )
+{
+    const std::chrono::milliseconds duration { argc > 2 ? std::strtol( argv[2], nullptr, 10 ) : 500 };
+
+    if( argc > 1 )
+    {
+        Report( unsigned( std::strtoul( argv[1], nullptr, 10 ) ), duration );
+    }
+    else
+    {
+        Report( 10, duration );
+        std::cout << std::endl;
+        Report( 100, duration );
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "RangeMap/DiskRangeMap.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+
+// Reports the throughput of DiskRangeMap and the page reads and writes per operation, for a
+// map many times larger than its buffer pool. The map is first filled with short ranges in key
+// order, then looked up and overwritten in key order and at random keys. Reads that miss the
+// buffer pool are usually served by the page cache of the operating system, so the results
+// show the cost of the pool misses rather than of the storage device.
+//
+// Usage: DiskBenchmark [ranges] [pool pages]
+
+
+using Map = DiskRangeMap<std::uint64_t, std::uint32_t>;
+
+
+
+template<typename F>
+void Run( std::string const& name, Map& map, std::size_t count, F&& fn )
+{
+    const DiskIoStats before { map.io_stats() };
+    const auto        start  { std::chrono::steady_clock::now() };
+
+    for( std::size_t n{0}; n < count; ++n )
+    {
+        fn( n );
+    }
+
+    const double      seconds { std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() };
+    const DiskIoStats after   { map.io_stats() };
+
+    std::cout << std::left  << std::setw(24) << name
+              << std::right << std::fixed << std::setprecision(2)
+              << std::setw(16) << double( count ) / seconds / 1e6
+              << std::setw(16) << double( after.pageReads  - before.pageReads  ) / double( count )
+              << std::setw(16) << double( after.pageWrites - before.pageWrites ) / double( count )
+              << std::endl;
+}
+
+
+
+int main( int argc, char** argv )
+{
+    const std::size_t ranges    { argc > 1 ? std::size_t( std::strtoull( argv[1], nullptr, 10 ) ) : 1'000'000 };
+    const std::size_t poolPages { argc > 2 ? std::size_t( std::strtoull( argv[2], nullptr, 10 ) ) : 256 };
+
+    const std::filesystem::path path { std::filesystem::temp_directory_path() / "DiskBenchmark.db" };
+    std::filesystem::remove( path );
+
+    {
+        Map map { path.string(), 0, poolPages };
+
+        // every range is followed by a gap, so it adds two boundaries
+        const std::uint64_t stride { 16 };
+        const std::uint64_t keyEnd { ranges * stride };
+
+        std::mt19937_64 gen { 42 };
+        std::uniform_int_distribution<std::uint64_t> distKey { 0, keyEnd };
+        std::uniform_int_distribution<std::uint32_t> distVal { 1, 15 };
+
+        std::cout << "million operations per second and pages read and written per operation" << std::endl;
+        std::cout << std::left  << std::setw(24) << ""
+                  << std::right << std::setw(16) << "Mops/s"
+                  << std::setw(16) << "reads/op"
+                  << std::setw(16) << "writes/op"
+                  << std::endl;
+
+        Run( "sequential assign", map, ranges, [&]( std::size_t n ) { map.assign( n * stride, n * stride + 8, distVal(gen) ); } );
+        Run( "sync",              map, 1,      [&]( std::size_t )   { map.sync(); } );
+
+        std::cout << "file of " << std::filesystem::file_size( path ) / DiskPageFile::PageSize << " pages, "
+                  << map.size() << " boundaries, pool of " << poolPages << " pages" << std::endl;
+
+        std::uint64_t checksum { 0 };
+        Run( "sequential lookup", map, ranges, [&]( std::size_t n ) { checksum += map[n * stride + 3]; } );
+        Run( "random lookup",     map, ranges, [&]( std::size_t )   { checksum += map[distKey(gen)]; } );
+        Run( "sequential assign", map, ranges, [&]( std::size_t n ) { map.assign( n * stride + 4, n * stride + 12, distVal(gen) ); } );
+        Run( "random assign",     map, ranges, [&]( std::size_t )   { const std::uint64_t key { distKey(gen) }; map.assign( key, key + 8, distVal(gen) ); } );
+        Run( "sync",              map, 1,      [&]( std::size_t )   { map.sync(); } );
+
+        std::cout << "(checksum " << checksum << ")" << std::endl;
+    }
+
+    std::filesystem::remove( path );
+
+    return 0;
+}
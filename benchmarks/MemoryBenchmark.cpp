@@ -0,0 +1,139 @@
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/PersistentRangeMap.h"
+#include "RangeMap/BlockCodecs.h"
+#include "RangeMap/ConcurrentRangeMap.h"
+#include "RangeMap/ShiftableRangeMap.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+
+// Reports the bytes used per stored range by each container, after the same sequence of
+// assignments. Most assignments are short ranges scattered over a large key space, with a
+// few long ones overwriting many of them, so the maps end up fragmented like long-lived
+// maps in production.
+//
+// Usage: MemoryBenchmark [assignments]
+
+
+struct Assignment
+{
+    std::uint64_t keyBegin;
+    std::uint64_t keyEnd;
+    std::uint32_t value;
+};
+
+
+
+std::vector<Assignment> MakeAssignments( std::size_t count )
+{
+    std::mt19937_64 gen { 42 };
+    std::uniform_int_distribution<std::uint64_t> distKey   { 0, 1'000'000'000 };
+    std::geometric_distribution<std::uint64_t>   distShort { 1.0 / 1'000 };
+    std::geometric_distribution<std::uint64_t>   distLong  { 1.0 / 1'000'000 };
+    std::uniform_int_distribution<std::uint32_t> distVal   { 0, 15 };
+    std::bernoulli_distribution                  isLong    { 0.01 };
+
+    std::vector<Assignment> out;
+    out.reserve( count );
+
+    for( std::size_t n{0}; n < count; ++n )
+    {
+        const std::uint64_t keyBegin { distKey(gen) };
+        const std::uint64_t length   { 1 + (isLong(gen) ? distLong(gen) : distShort(gen)) };
+
+        out.push_back( { keyBegin, keyBegin + length, distVal(gen) } );
+    }
+
+    return out;
+}
+
+
+
+// Keys like paths, sharing long prefixes, ordered the same way as the integer keys
+std::string StringKey( std::uint64_t key )
+{
+    std::string digits { std::to_string( key ) };
+    return "/tenants/0042/objects/" + std::string( 10 - digits.size(), '0' ) + digits;
+}
+
+
+
+void Report( std::string const& name, RangeMapMemoryUsage const& usage )
+{
+    const double boundaries { double( usage.boundaries ? usage.boundaries : 1 ) };
+
+    std::cout << std::left  << std::setw(40) << name
+              << std::right << std::setw(12) << usage.boundaries
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << double( usage.total() )     / boundaries
+              << std::setw(12) << double( usage.nodeBytes )   / boundaries
+              << std::setw(12) << double( usage.keyBytes )    / boundaries
+              << std::setw(12) << double( usage.valueBytes )  / boundaries
+              << std::endl;
+}
+
+
+
+int main( int argc, char** argv )
+{
+    const std::size_t count { argc > 1 ? std::size_t( std::strtoull( argv[1], nullptr, 10 ) ) : 200'000 };
+
+    const auto assignments { MakeAssignments( count ) };
+
+    std::cout << std::left  << std::setw(40) << "bytes per boundary after " + std::to_string( count ) + " assignments"
+              << std::right << std::setw(12) << "boundaries"
+              << std::setw(12) << "total"
+              << std::setw(12) << "nodes"
+              << std::setw(12) << "keys"
+              << std::setw(12) << "values"
+              << std::endl;
+
+    {
+        RangeMap<std::uint64_t, std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( a.keyBegin, a.keyEnd, a.value ); }
+        Report( "RangeMap<uint64_t,uint32_t>", rangeMap.memory_usage() );
+    }
+
+    {
+        PersistentRangeMap<std::uint64_t, std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( a.keyBegin, a.keyEnd, a.value ); }
+        Report( "PersistentRangeMap<uint64_t,uint32_t>", rangeMap.memory_usage() );
+    }
+
+    {
+        ShiftableRangeMap<std::uint64_t, std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( a.keyBegin, a.keyEnd, a.value ); }
+        Report( "ShiftableRangeMap<uint64_t,uint32_t>", rangeMap.memory_usage() );
+    }
+
+    {
+        ConcurrentRangeMap<std::uint64_t, std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( a.keyBegin, a.keyEnd, a.value ); }
+        Report( "ConcurrentRangeMap<uint64_t,uint32_t>", rangeMap.memory_usage() );
+    }
+
+    {
+        CompactRangeMap<std::uint64_t, std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( a.keyBegin, a.keyEnd, a.value ); }
+        Report( "CompactRangeMap<uint64_t,uint32_t>", rangeMap.memory_usage() );
+    }
+
+    {
+        RangeMap<std::string, std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( StringKey( a.keyBegin ), StringKey( a.keyEnd ), a.value ); }
+        Report( "RangeMap<string,uint32_t>", rangeMap.memory_usage() );
+    }
+
+    {
+        StringRangeMap<std::uint32_t> rangeMap { 0 };
+        for( auto const& a : assignments ) { rangeMap.assign( StringKey( a.keyBegin ), StringKey( a.keyEnd ), a.value ); }
+        Report( "StringRangeMap<uint32_t>", rangeMap.memory_usage() );
+    }
+
+    return 0;
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stop_token>
+#include <thread>
+
+
+/**
+ * @brief A RangeMap front end where 'assign()' does not wait for the map. Assignments are
+ *        pushed onto a lock-free multi-producer queue and applied in batches by a background
+ *        thread. Before touching the map, the applier combines the overlapping and adjacent
+ *        assignments of a batch, so each range of the batch is written once.
+ *
+ *        Assignments become visible to 'operator[]' some time after 'assign()' returns; call
+ *        'flush()' to wait until they are. Assignments are applied in the order in which they
+ *        were pushed onto the queue.
+ *
+ * @tparam K  The key type, must be copyable, assignable and less-than comparable via operator<
+ * @tparam V  The value type, must be copyable, assignable and equality-comparable via operator==
+ */
+template<typename K, typename V>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V>
+class AsyncRangeMap
+{
+  public:
+    /**
+     * @brief Construct a new Async Range Map object where the whole range of K is associated
+     *        with value 'defaultVal', and start its background applier thread.
+     */
+    AsyncRangeMap( V const& defaultVal )
+    : mMap     { defaultVal }
+    , mApplier { [this]( std::stop_token stopToken ){ ApplierLoop( stopToken ); } }
+    {}
+
+
+
+    /**
+     * @brief Applies all queued assignments and stops the background applier thread.
+     */
+    ~AsyncRangeMap();
+
+
+
+    AsyncRangeMap( AsyncRangeMap const& )            = delete;
+    AsyncRangeMap& operator=( AsyncRangeMap const& ) = delete;
+
+
+
+    /**
+     * @brief Queues the assignment of 'keyVal' to range ['keyBegin', 'keyEnd'[. This call is
+     *        lock-free and never waits for the background applier.
+     */
+    void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Blocks until all assignments queued before this call are visible to 'operator[]'.
+     */
+    void flush();
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key'. The value is returned by copy,
+     *        since the applier can overwrite it as soon as this call returns.
+     */
+    V operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Returns the memory used by the applied ranges, see 'RangeMap::memory_usage()'.
+     *        Assignments still in the queue are not counted.
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+  private:
+    struct PendingAssign
+    {
+        K              keyBegin;
+        K              keyEnd;
+        V              keyVal;
+        PendingAssign* next;
+    };
+
+
+    /**
+     * @brief Body of the background thread, applies queued assignments until stop is requested
+     *        and the queue is empty.
+     */
+    void ApplierLoop( std::stop_token stopToken );
+
+
+    /**
+     * @brief Combines and applies a batch of assignments, then deletes them.
+     *
+     * @param newestFirst  The batch as taken from the queue, linked from newest to oldest.
+     */
+    void ApplyBatch( PendingAssign* newestFirst );
+
+
+    // Member variables
+    std::atomic<PendingAssign*> mQueueHead { nullptr }; // Lock-free stack of queued assignments, newest first
+    std::atomic<std::uint64_t>  mReserved  { 0 };       // Assignments about to be or already queued
+    std::atomic<std::uint64_t>  mPushed    { 0 };       // Assignments queued, used to wake up the applier
+    std::atomic<std::uint64_t>  mApplied   { 0 };       // Assignments visible in 'mMap'
+
+    mutable std::shared_mutex   mMapMutex;
+    RangeMap<K,V>               mMap;
+
+    std::jthread                mApplier;               // Must be last, so it is stopped before the other members are destroyed
+};
+
+
+
+
+template<typename K, typename V>
+AsyncRangeMap<K,V>::~AsyncRangeMap()
+{
+    mApplier.request_stop();
+
+    mPushed.fetch_add( 1 ); // wake up the applier, so it sees the stop request
+    mPushed.notify_one();
+}
+
+
+
+template<typename K, typename V>
+void AsyncRangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // Construct the node before reserving, so that a throwing allocation or copy
+    // does not leave a reservation behind that 'flush()' would wait for forever
+    auto* pending = new PendingAssign { keyBegin, keyEnd, keyVal, nullptr };
+
+    // Reserve before pushing, so that a 'flush()' that observes this assignment
+    // also waits for it to be applied
+    mReserved.fetch_add( 1 );
+
+    pending->next = mQueueHead.load( std::memory_order_relaxed );
+
+    while( !mQueueHead.compare_exchange_weak( pending->next, pending, std::memory_order_release, std::memory_order_relaxed ) )
+    {
+    }
+
+    mPushed.fetch_add( 1 );
+    mPushed.notify_one();
+}
+
+
+
+template<typename K, typename V>
+void AsyncRangeMap<K,V>::flush()
+{
+    const std::uint64_t target { mReserved.load() };
+
+    // The applier takes the whole queue at once, so once 'target' assignments are
+    // applied, every assignment queued before this call is among them
+    std::uint64_t applied { mApplied.load() };
+    while( applied < target )
+    {
+        mApplied.wait( applied );
+        applied = mApplied.load();
+    }
+}
+
+
+
+template<typename K, typename V>
+V AsyncRangeMap<K,V>::operator[]( K const& key ) const
+{
+    std::shared_lock lock { mMapMutex };
+
+    return mMap[key];
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage AsyncRangeMap<K,V>::memory_usage() const
+{
+    std::shared_lock lock { mMapMutex };
+
+    return mMap.memory_usage();
+}
+
+
+
+template<typename K, typename V>
+void AsyncRangeMap<K,V>::ApplierLoop( std::stop_token stopToken )
+{
+    while( true )
+    {
+        // Read the counter before taking the queue, so that an assignment pushed after
+        // the queue was found empty is guaranteed to end the wait below
+        const std::uint64_t pushed { mPushed.load() };
+
+        PendingAssign* batch { mQueueHead.exchange( nullptr, std::memory_order_acquire ) };
+
+        if( batch )
+        {
+            ApplyBatch( batch );
+        }
+        else if( stopToken.stop_requested() )
+        {
+            break;
+        }
+        else
+        {
+            mPushed.wait( pushed );
+        }
+    }
+}
+
+
+
+template<typename K, typename V>
+void AsyncRangeMap<K,V>::ApplyBatch( PendingAssign* newestFirst )
+{
+    // Reverse the batch to oldest first and combine it. Later assignments
+    // overwrite earlier ones, and equal adjacent values are merged.
+    RangeMap<K, std::optional<V>> combined { std::nullopt };
+
+    PendingAssign* oldestFirst { nullptr };
+    while( newestFirst )
+    {
+        PendingAssign* next { newestFirst->next };
+        newestFirst->next = oldestFirst;
+        oldestFirst       = newestFirst;
+        newestFirst       = next;
+    }
+
+    std::uint64_t count { 0 };
+    while( oldestFirst )
+    {
+        combined.assign( oldestFirst->keyBegin, oldestFirst->keyEnd, oldestFirst->keyVal );
+
+        PendingAssign* next { oldestFirst->next };
+        delete oldestFirst;
+        oldestFirst = next;
+        ++count;
+    }
+
+    {
+        std::unique_lock lock { mMapMutex };
+
+        // Each combined range ends where the next one begins, and the last
+        // element always holds the default (empty) value
+        auto const& ranges = combined.data();
+        for( auto it = ranges.begin(); it != ranges.end() && std::next(it) != ranges.end(); ++it )
+        {
+            if( it->second )
+            {
+                mMap.assign( it->first, std::next(it)->first, *it->second );
+            }
+        }
+    }
+
+    mApplied.fetch_add( count );
+    mApplied.notify_all();
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include "RangeMap/BlockedRangeMap.h"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * @brief Appends 'value' to 'out' as a variable length integer, 7 bits per byte with the
+ *        high bit set on all bytes but the last.
+ */
+inline void AppendVarUint( std::string& out, std::uint64_t value )
+{
+    while( value >= 0x80 )
+    {
+        out.push_back( char( (value & 0x7F) | 0x80 ) );
+        value >>= 7;
+    }
+    out.push_back( char( value ) );
+}
+
+
+
+/**
+ * @brief Reads a variable length integer written by 'AppendVarUint()' at 'pos', and moves
+ *        'pos' past it.
+ */
+inline std::uint64_t ReadVarUint( std::string const& in, std::size_t& pos )
+{
+    std::uint64_t value { 0 };
+    unsigned      shift { 0 };
+
+    while( true )
+    {
+        const auto byte { static_cast<unsigned char>( in[pos++] ) };
+        value |= std::uint64_t( byte & 0x7F ) << shift;
+
+        if( !(byte & 0x80) )
+        {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+
+
+/**
+ * @brief Block codec for 'std::string' keys using front coding: every key is stored as the
+ *        length of the prefix it shares with the previous key, followed by the rest of it.
+ *
+ *        Lookups compare the searched key against the block without decoding it. The length
+ *        of the prefix the searched key shares with the current key is tracked, so bytes of a
+ *        shared prefix are never compared twice.
+ */
+struct FrontCodedStringCodec
+{
+    using Block = std::string; // Per key: varint shared prefix length, varint suffix length, suffix bytes
+
+
+    static Block encode( std::string const* keys, std::size_t count )
+    {
+        Block out;
+
+        for( std::size_t index{1}; index < count; ++index )
+        {
+            std::string const& prev { keys[index - 1] };
+            std::string const& key  { keys[index] };
+
+            const std::size_t shared { std::size_t( std::mismatch( prev.begin(), prev.end(), key.begin(), key.end() ).first - prev.begin() ) };
+
+            AppendVarUint( out, shared );
+            AppendVarUint( out, key.size() - shared );
+            out.append( key, shared );
+        }
+
+        return out;
+    }
+
+
+    static void decode( std::string const& firstKey, Block const& block, std::vector<std::string>& out )
+    {
+        std::string key { firstKey };
+        out.push_back( key );
+
+        std::size_t pos { 0 };
+        while( pos < block.size() )
+        {
+            const std::size_t shared { ReadVarUint( block, pos ) };
+            const std::size_t length { ReadVarUint( block, pos ) };
+
+            key.resize( shared );
+            key.append( block, pos, length );
+            pos += length;
+
+            out.push_back( key );
+        }
+    }
+
+
+    static std::size_t count_not_greater( std::string const& firstKey, Block const& block, std::string_view key )
+    {
+        // 'matched' is the length of the prefix 'key' shares with the last key that was
+        // found to be less than or equal to 'key'
+        std::size_t matched { std::size_t( std::mismatch( firstKey.begin(), firstKey.end(), key.begin(), key.end() ).first - firstKey.begin() ) };
+        std::size_t count   { 1 };
+        std::size_t pos     { 0 };
+
+        while( pos < block.size() )
+        {
+            const std::size_t shared { ReadVarUint( block, pos ) };
+            const std::size_t length { ReadVarUint( block, pos ) };
+
+            if( shared > matched )
+            {
+                // Same byte as the previous key where it differs from 'key', so still less than 'key'
+            }
+            else if( shared < matched )
+            {
+                // Differs from the previous key where it still matched 'key', and keys are
+                // sorted, so this key and all following keys are greater than 'key'
+                break;
+            }
+            else
+            {
+                // Compare the suffix with the part of 'key' that is not matched yet
+                std::string_view suffix    { block.data() + pos, length };
+                std::string_view remaining { key.substr( matched ) };
+
+                const std::size_t common { std::size_t( std::mismatch( suffix.begin(), suffix.end(), remaining.begin(), remaining.end() ).first - suffix.begin() ) };
+
+                const bool isGreater { common < suffix.size() &&
+                                       (common == remaining.size() ||
+                                        static_cast<unsigned char>(remaining[common]) < static_cast<unsigned char>(suffix[common])) };
+                if( isGreater )
+                {
+                    break;
+                }
+
+                matched += common;
+            }
+
+            pos += length;
+            ++count;
+        }
+
+        return count;
+    }
+};
+
+
+
+/**
+ * @brief A range map for lexicographic 'std::string' ranges, storing the range boundaries
+ *        front coded in blocks.
+ */
+template<typename V, std::size_t BlockSize = 64>
+using StringRangeMap = BlockedRangeMap<std::string, V, FrontCodedStringCodec, BlockSize>;
+
+
+
+/**
+ * @brief The keys of a block encoded by 'DeltaBitPackedCodec'.
+ */
+struct BitPackedBlock
+{
+    std::vector<std::uint64_t> words;       // Packed deltas, 'width' bits each, starting at the low bits of each word
+    std::uint32_t              count { 0 }; // Number of packed deltas
+    std::uint8_t               width { 0 }; // Bits per delta, 0 when all keys are consecutive
+};
+
+
+
+template<>
+struct RangeMapHeapBytes<BitPackedBlock>
+{
+    std::size_t operator()( BitPackedBlock const& block ) const
+    {
+        return RangeMapHeapBytes<std::vector<std::uint64_t>>{}( block.words );
+    }
+};
+
+
+
+/**
+ * @brief Block codec for integer keys: every key is stored as its distance to the previous key,
+ *        minus one since keys are distinct, and all distances of a block are bit packed with the
+ *        width of the largest one. Densely spaced boundaries take a few bits per key instead of
+ *        the full width of 'K'.
+ *
+ *        Lookups add up the distances until they pass the searched key, without decoding the
+ *        block into a separate array.
+ */
+template<std::integral K>
+struct DeltaBitPackedCodec
+{
+    using Block    = BitPackedBlock;
+    using Unsigned = std::make_unsigned_t<K>; // Distances between sorted keys always fit, also for signed keys
+
+
+    static Block encode( K const* keys, std::size_t count )
+    {
+        Block block;
+        if( count < 2 )
+        {
+            return block;
+        }
+
+        std::uint64_t maxDelta { 0 };
+        for( std::size_t index{1}; index < count; ++index )
+        {
+            maxDelta = std::max( maxDelta, Delta( keys[index - 1], keys[index] ) );
+        }
+
+        block.count = std::uint32_t( count - 1 );
+        block.width = std::uint8_t( std::bit_width( maxDelta ) );
+        block.words.resize( (std::size_t( block.count ) * block.width + 63) / 64 );
+
+        for( std::size_t index{0}; index < block.count && block.width > 0; ++index )
+        {
+            const std::uint64_t delta  { Delta( keys[index], keys[index + 1] ) };
+            const std::size_t   bitPos { index * block.width };
+            const std::size_t   word   { bitPos / 64 };
+            const unsigned      offset { unsigned( bitPos % 64 ) };
+
+            block.words[word] |= delta << offset;
+            if( offset + block.width > 64 )
+            {
+                block.words[word + 1] |= delta >> (64 - offset);
+            }
+        }
+
+        return block;
+    }
+
+
+    static void decode( K const& firstKey, Block const& block, std::vector<K>& out )
+    {
+        Unsigned key { Unsigned( firstKey ) };
+        out.push_back( firstKey );
+
+        for( std::size_t index{0}; index < block.count; ++index )
+        {
+            key = Unsigned( key + Unpack( block, index ) + 1 );
+            out.push_back( K( key ) );
+        }
+    }
+
+
+    static std::size_t count_not_greater( K const& firstKey, Block const& block, K const& key )
+    {
+        // distance of 'key' to the first key, and of each stored key to the first key
+        const std::uint64_t target   { Unsigned( Unsigned( key ) - Unsigned( firstKey ) ) };
+        std::uint64_t       distance { 0 };
+        std::size_t         count    { 1 };
+
+        for( std::size_t index{0}; index < block.count; ++index )
+        {
+            distance += Unpack( block, index ) + 1;
+            if( distance > target )
+            {
+                break;
+            }
+            ++count;
+        }
+
+        return count;
+    }
+
+
+  private:
+    static std::uint64_t Delta( K const& prev, K const& key )
+    {
+        return std::uint64_t( Unsigned( Unsigned( key ) - Unsigned( prev ) ) ) - 1;
+    }
+
+
+    static std::uint64_t Unpack( Block const& block, std::size_t index )
+    {
+        if( block.width == 0 )
+        {
+            return 0;
+        }
+
+        const std::size_t bitPos { index * block.width };
+        const std::size_t word   { bitPos / 64 };
+        const unsigned    offset { unsigned( bitPos % 64 ) };
+
+        std::uint64_t value { block.words[word] >> offset };
+        if( offset + block.width > 64 )
+        {
+            value |= block.words[word + 1] << (64 - offset);
+        }
+
+        return block.width == 64 ? value : value & ((std::uint64_t(1) << block.width) - 1);
+    }
+};
+
+
+
+/**
+ * @brief A range map for integer keys, storing the range boundaries delta encoded and bit
+ *        packed in blocks. Suited for maps with far more boundaries than fit in a 'RangeMap'.
+ */
+template<std::integral K, typename V, std::size_t BlockSize = 64>
+using CompactRangeMap = BlockedRangeMap<K, V, DeltaBitPackedCodec<K>, BlockSize>;
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/FlatRangeAssign.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Requirements of a codec that compresses the sorted keys of a block of a
+ *        BlockedRangeMap. The first key of each block is stored uncompressed in the skip
+ *        index, and the codec encodes the keys after it, typically relative to it.
+ *
+ *        C::encode( keys, count )                  Encodes keys[1] .. keys[count-1]
+ *        C::decode( firstKey, block, out )         Appends the first key and the decoded keys to 'out'
+ *        C::count_not_greater( firstKey, block, k) Returns the number of keys in the block that are <= 'k',
+ *                                                  where 'firstKey' <= 'k'
+ */
+template<typename C, typename K>
+concept is_block_key_codec =
+    requires( K const& key, K const* keys, std::size_t count, typename C::Block const& block, std::vector<K>& out )
+    {
+        { C::encode( keys, count ) }                  -> std::same_as<typename C::Block>;
+        { C::decode( key, block, out ) };
+        { C::count_not_greater( key, block, key ) }   -> std::same_as<std::size_t>;
+    };
+
+
+
+/**
+ * @brief A range map that stores its range boundaries in sorted blocks of up to 'BlockSize'
+ *        elements, with the keys of each block compressed by 'Codec'. A skip index holds the
+ *        first key of every block, so a lookup binary searches the skip index and then only
+ *        scans the compressed keys of a single block.
+ *
+ *        'assign()' decodes the one or two blocks the range touches, updates them and encodes
+ *        them again. Its runtime is O(log N + BlockSize) plus moving the skip index entries
+ *        after the range, which are BlockSize times fewer than the stored boundaries.
+ *
+ * @tparam K          The key type, must be copyable, assignable and less-than comparable via operator<
+ * @tparam V          The value type, must be copyable, assignable and equality-comparable via operator==
+ * @tparam Codec      Compresses the keys of a block, see 'is_block_key_codec'
+ * @tparam BlockSize  The maximum number of boundaries per block
+ */
+template<typename K, typename V, typename Codec, std::size_t BlockSize = 64>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V> &&
+
+                  is_block_key_codec<Codec, K> &&
+             (BlockSize >= 2)
+class BlockedRangeMap
+{
+  public:
+    /**
+     * @brief Construct a new Blocked Range Map object where the whole range of K
+     *        is associated with value 'defaultVal'.
+     */
+    BlockedRangeMap( V const& defaultVal )
+    : mDefaultVal { defaultVal }
+    {}
+
+
+
+    /**
+     * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[, overwriting any previous
+     *        values which overlap with this range. Ranges where 'keyEnd' is not greater
+     *        than 'keyBegin' are ignored.
+     *
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range. Note that the range excludes 'keyEnd'.
+     * @param keyVal    The value to associate to the range ['keyBegin', 'keyEnd'[
+     */
+    void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key'
+     *
+     * @param key  The key to lookup
+     * @return     The value associated with 'key'
+     */
+    V const& operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Returns the number of stored range boundaries.
+     */
+    std::size_t size() const;
+
+
+
+    /**
+     * @brief Calls 'fn(key, value)' for every stored range boundary, in key order.
+     */
+    template<typename F>
+    void for_each( F&& fn ) const;
+
+
+
+    /**
+     * @brief Returns the stored range boundaries as a 'std::map', in the layout used
+     *        by 'RangeMap::data()'. The runtime is O(N).
+     */
+    std::map<K,V> to_map() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the skip index and the blocks. The compressed keys
+     *        and the skip index are counted as key bytes. The runtime is O(N / BlockSize).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+    /**
+     * @brief Copies the stored range boundaries into two parallel arrays, laid out like
+     *        'RangeMap::export_columns()'. The values of each block are already stored
+     *        contiguously, so they are copied block by block.
+     *
+     * @param keys    Receives the range boundaries, should have room for 'size()' keys.
+     * @param values  Receives the projected values, should have room for as many values.
+     * @param proj    Callable as 'proj(V const&)', converts a value to the type of 'values'.
+     * @return        The number of ranges written, limited by the size of the buffers.
+     */
+    template<typename Out, typename Proj = std::identity>
+        requires std::is_assignable_v<Out&, std::invoke_result_t<Proj&, V const&>>
+    std::size_t export_columns( std::span<K> keys, std::span<Out> values, Proj proj = {} ) const;
+
+
+
+  private:
+    struct Block
+    {
+        typename Codec::Block keys;   // Compressed keys, except the first one which is in 'mFirstKeys'
+        std::vector<V>        values; // The value of each boundary of the block
+    };
+
+
+    /**
+     * @brief Appends the boundaries of block 'index' to 'entries'.
+     */
+    void DecodeBlock( std::size_t index, std::vector<std::pair<K,V>>& entries ) const;
+
+
+    // Member variables
+    V                  mDefaultVal;   // Default value for values of 'K' that fall outside ranges
+    std::vector<K>     mFirstKeys;    // Skip index, the first key of each block
+    std::vector<Block> mBlocks;       // Blocks of range boundaries, ordered by key
+    std::size_t        mSize { 0 };   // Number of stored range boundaries
+};
+
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+void BlockedRangeMap<K,V,Codec,BlockSize>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // ignore invalid range
+    if( !(keyBegin < keyEnd) )
+    {
+        return;
+    }
+
+    // The blocks holding the boundaries in ['keyBegin', 'keyEnd'], plus the block holding the
+    // boundary before 'keyBegin', are the only ones that can change
+    std::size_t firstBlock = std::size_t( std::upper_bound( mFirstKeys.begin(), mFirstKeys.end(), keyBegin ) - mFirstKeys.begin() );
+    std::size_t lastBlock  = std::size_t( std::upper_bound( mFirstKeys.begin(), mFirstKeys.end(), keyEnd   ) - mFirstKeys.begin() );
+    if( firstBlock > 0 )
+    {
+        --firstBlock;
+    }
+
+    std::vector<std::pair<K,V>> entries;
+    for( std::size_t index{firstBlock}; index < lastBlock; ++index )
+    {
+        DecodeBlock( index, entries );
+    }
+
+    // Merge small blocks with the next block, so blocks stay at least half full on average
+    if( entries.size() < BlockSize / 2 && lastBlock < mBlocks.size() )
+    {
+        DecodeBlock( lastBlock, entries );
+        ++lastBlock;
+    }
+
+    const std::size_t sizeBefore { entries.size() };
+
+    V const& valueBefore { firstBlock == 0 ? mDefaultVal : mBlocks[firstBlock - 1].values.back() };
+    FlatRangeAssign( entries, valueBefore, keyBegin, keyEnd, keyVal );
+
+    // Split the updated boundaries into evenly filled blocks
+    const std::size_t numBlocks { (entries.size() + BlockSize - 1) / BlockSize };
+
+    std::vector<K>     firstKeys;
+    std::vector<Block> blocks;
+    firstKeys.reserve( numBlocks );
+    blocks.reserve( numBlocks );
+
+    std::vector<K> keys;
+    std::size_t    begin { 0 };
+    for( std::size_t index{0}; index < numBlocks; ++index )
+    {
+        const std::size_t end { entries.size() * (index + 1) / numBlocks };
+
+        keys.clear();
+        Block block;
+        block.values.reserve( end - begin );
+        for( std::size_t pos{begin}; pos < end; ++pos )
+        {
+            keys.push_back( entries[pos].first );
+            block.values.push_back( entries[pos].second );
+        }
+        block.keys = Codec::encode( keys.data(), keys.size() );
+
+        firstKeys.push_back( keys.front() );
+        blocks.push_back( std::move(block) );
+        begin = end;
+    }
+
+    auto const firstPos = std::ptrdiff_t(firstBlock);
+    auto const lastPos  = std::ptrdiff_t(lastBlock);
+
+    mFirstKeys.erase ( mFirstKeys.begin() + firstPos, mFirstKeys.begin() + lastPos );
+    mFirstKeys.insert( mFirstKeys.begin() + firstPos, std::make_move_iterator(firstKeys.begin()), std::make_move_iterator(firstKeys.end()) );
+    mBlocks.erase    ( mBlocks.begin() + firstPos, mBlocks.begin() + lastPos );
+    mBlocks.insert   ( mBlocks.begin() + firstPos, std::make_move_iterator(blocks.begin()), std::make_move_iterator(blocks.end()) );
+
+    mSize = mSize - sizeBefore + entries.size();
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+V const& BlockedRangeMap<K,V,Codec,BlockSize>::operator[]( K const& key ) const
+{
+    auto it = std::upper_bound( mFirstKeys.begin(), mFirstKeys.end(), key );
+
+    if( it == mFirstKeys.begin() )
+    {
+        return mDefaultVal;
+    }
+
+    const std::size_t index { std::size_t( std::prev(it) - mFirstKeys.begin() ) };
+    const std::size_t count { Codec::count_not_greater( mFirstKeys[index], mBlocks[index].keys, key ) };
+
+    return mBlocks[index].values[count - 1];
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+std::size_t BlockedRangeMap<K,V,Codec,BlockSize>::size() const
+{
+    return mSize;
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+template<typename F>
+void BlockedRangeMap<K,V,Codec,BlockSize>::for_each( F&& fn ) const
+{
+    std::vector<std::pair<K,V>> entries;
+
+    for( std::size_t index{0}; index < mBlocks.size(); ++index )
+    {
+        entries.clear();
+        DecodeBlock( index, entries );
+
+        for( auto const& [key, value] : entries )
+        {
+            fn( key, value );
+        }
+    }
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+std::map<K,V> BlockedRangeMap<K,V,Codec,BlockSize>::to_map() const
+{
+    std::map<K,V> out;
+
+    for_each( [&out]( K const& key, V const& value ){ out.emplace_hint( out.end(), key, value ); } );
+
+    return out;
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+template<typename Out, typename Proj>
+    requires std::is_assignable_v<Out&, std::invoke_result_t<Proj&, V const&>>
+std::size_t BlockedRangeMap<K,V,Codec,BlockSize>::export_columns( std::span<K> keys, std::span<Out> values, Proj proj ) const
+{
+    const std::size_t count { std::min( { mSize, keys.size(), values.size() } ) };
+
+    std::vector<K> blockKeys;
+    std::size_t    written { 0 };
+    for( std::size_t index{0}; index < mBlocks.size() && written < count; ++index )
+    {
+        blockKeys.clear();
+        Codec::decode( mFirstKeys[index], mBlocks[index].keys, blockKeys );
+
+        const std::size_t blockCount { std::min( blockKeys.size(), count - written ) };
+        auto const&       blockValues = mBlocks[index].values;
+
+        std::move     ( blockKeys.begin(),   blockKeys.begin()   + std::ptrdiff_t(blockCount), keys.begin()   + std::ptrdiff_t(written) );
+        std::transform( blockValues.begin(), blockValues.begin() + std::ptrdiff_t(blockCount), values.begin() + std::ptrdiff_t(written), proj );
+
+        written += blockCount;
+    }
+
+    return written;
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+RangeMapMemoryUsage BlockedRangeMap<K,V,Codec,BlockSize>::memory_usage() const
+{
+    RangeMapMemoryUsage usage;
+    usage.boundaries = mSize;
+    usage.nodeBytes  = (mFirstKeys.capacity() - mFirstKeys.size()) * sizeof(K) + mBlocks.capacity() * sizeof(Block);
+
+    for( K const& key : mFirstKeys )
+    {
+        usage.keyBytes += ObjectBytes( key );
+    }
+
+    for( Block const& block : mBlocks )
+    {
+        usage.keyBytes   += RangeMapHeapBytes<typename Codec::Block>{}( block.keys );
+        usage.valueBytes += RangeMapHeapBytes<std::vector<V>>{}( block.values );
+    }
+
+    return usage;
+}
+
+
+
+template<typename K, typename V, typename Codec, std::size_t BlockSize>
+void BlockedRangeMap<K,V,Codec,BlockSize>::DecodeBlock( std::size_t index, std::vector<std::pair<K,V>>& entries ) const
+{
+    std::vector<K> keys;
+    Codec::decode( mFirstKeys[index], mBlocks[index].keys, keys );
+
+    for( std::size_t pos{0}; pos < keys.size(); ++pos )
+    {
+        entries.emplace_back( std::move(keys[pos]), mBlocks[index].values[pos] );
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+
+/**
+ * @brief The range boundaries of a RangeMap copied into a sorted array, for looking up many
+ *        keys at once. The values are not copied but pointed to, so the RangeMap must not be
+ *        changed while the index is used.
+ *
+ *        Sorted runs of keys are looked up with a merge walk that gallops forward from the
+ *        previous key, so each lookup costs O(log d) for a distance of d boundaries. Other
+ *        keys are looked up 'Lanes' at a time with branchless binary searches that step in
+ *        lockstep, so the cache misses of the independent searches overlap.
+ */
+template<typename K, typename V, typename Compare = std::less<K>>
+class FlatRangeIndex
+{
+  public:
+    static constexpr std::size_t Lanes { 8 };
+
+
+    /**
+     * @brief Builds the index of 'map' in O(N).
+     */
+    explicit FlatRangeIndex( RangeMap<K,V,Compare> const& map )
+    : mCompare { map.data().key_comp() }
+    {
+        mKeys.reserve( map.data().size() );
+        mValues.reserve( map.data().size() + 1 );
+
+        // 'mValues' is shifted by one, so that index 0, for keys before the first boundary, holds the default
+        mValues.push_back( &map.default_value() );
+        for( auto const& [key, value] : map.data() )
+        {
+            mKeys.push_back( key );
+            mValues.push_back( &value );
+        }
+    }
+
+
+
+    /**
+     * @brief Writes the value associated with 'keys[i]' to 'out[i]'. 'out' must have room
+     *        for as many values as there are keys.
+     */
+    void lookup( std::span<K const> keys, std::span<V> out ) const
+    {
+        assert( out.size() >= keys.size() && "FlatRangeIndex: 'out' is smaller than 'keys'" );
+
+        if( std::is_sorted( keys.begin(), keys.end(), mCompare ) )
+        {
+            LookupSorted( keys, out );
+        }
+        else
+        {
+            LookupUnsorted( keys, out );
+        }
+    }
+
+
+
+  private:
+    /**
+     * @brief Returns the number of boundaries not greater than 'key', given that the first
+     *        'from' boundaries are not greater than it.
+     */
+    std::size_t CountNotGreater( K const& key, std::size_t from ) const
+    {
+        // gallop to a boundary greater than 'key', then binary search the last step
+        std::size_t bound { from };
+        std::size_t step  { 1 };
+        while( bound < mKeys.size() && !mCompare( key, mKeys[bound] ) )
+        {
+            from   = bound + 1;
+            bound += step;
+            step  *= 2;
+        }
+
+        auto const last = mKeys.begin() + std::ptrdiff_t( std::min( bound, mKeys.size() ) );
+        return std::size_t( std::upper_bound( mKeys.begin() + std::ptrdiff_t( from ), last, key, mCompare ) - mKeys.begin() );
+    }
+
+
+    void LookupSorted( std::span<K const> keys, std::span<V> out ) const
+    {
+        std::size_t count { 0 };
+        for( std::size_t index{0}; index < keys.size(); ++index )
+        {
+            count      = CountNotGreater( keys[index], count );
+            out[index] = *mValues[count];
+        }
+    }
+
+
+    void LookupUnsorted( std::span<K const> keys, std::span<V> out ) const
+    {
+        const std::size_t size { mKeys.size() };
+        K const*          data { mKeys.data() };
+
+        std::size_t index { 0 };
+        for( ; index + Lanes <= keys.size(); index += Lanes )
+        {
+            // narrow down to the last boundary not greater than each key, or the first boundary if there is none
+            std::array<std::size_t, Lanes> base {};
+            for( std::size_t length{size}; length > 1; length -= length / 2 )
+            {
+                const std::size_t half { length / 2 };
+                for( std::size_t lane{0}; lane < Lanes; ++lane )
+                {
+                    base[lane] = mCompare( keys[index + lane], data[base[lane] + half] ) ? base[lane] : base[lane] + half;
+                }
+            }
+
+            for( std::size_t lane{0}; lane < Lanes; ++lane )
+            {
+                const bool isAfterBase { size > 0 && !mCompare( keys[index + lane], data[base[lane]] ) };
+                out[index + lane] = *mValues[base[lane] + (isAfterBase ? 1 : 0)];
+            }
+        }
+
+        for( ; index < keys.size(); ++index )
+        {
+            out[index] = *mValues[CountNotGreater( keys[index], 0 )];
+        }
+    }
+
+
+    // Member variables
+    Compare               mCompare;  // Orders the keys like the RangeMap
+    std::vector<K>        mKeys;     // Range boundaries, sorted
+    std::vector<V const*> mValues;   // The default value, followed by the value of each boundary
+};
+
+
+
+/**
+ * @brief Writes the value associated with 'keys[i]' in 'map' to 'out[i]', for every key,
+ *        spread over the threads of 'pool'. The keys are split into chunks of 'ChunkSize'
+ *        keys that are looked up by a FlatRangeIndex, which is fastest for chunks of sorted
+ *        keys. 'out' must have room for as many values as there are keys, and 'map' must not
+ *        be changed until the call returns.
+ */
+template<typename K, typename V, typename Compare>
+void classify( RangeMap<K,V,Compare> const& map, std::type_identity_t<std::span<K const>> keys, std::type_identity_t<std::span<V>> out, ThreadPool& pool )
+{
+    assert( out.size() >= keys.size() && "classify: 'out' is smaller than 'keys'" );
+
+    constexpr std::size_t ChunkSize { 16 * 1024 };
+
+    const FlatRangeIndex<K,V,Compare> index { map };
+    const std::size_t                 numChunks { (keys.size() + ChunkSize - 1) / ChunkSize };
+
+    pool.run( numChunks, [&]( std::size_t chunk )
+    {
+        const std::size_t first { chunk * ChunkSize };
+        const std::size_t count { std::min( ChunkSize, keys.size() - first ) };
+
+        index.lookup( keys.subspan( first, count ), out.subspan( first, count ) );
+    });
+}
+
+
+
+/**
+ * @brief Same as 'classify()' above, on the calling thread only.
+ */
+template<typename K, typename V, typename Compare>
+void classify( RangeMap<K,V,Compare> const& map, std::type_identity_t<std::span<K const>> keys, std::type_identity_t<std::span<V>> out )
+{
+    FlatRangeIndex<K,V,Compare>{ map }.lookup( keys, out );
+}
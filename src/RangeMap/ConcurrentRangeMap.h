@@ -0,0 +1,641 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/PersistentRangeMap.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A range map that any number of threads can assign to and read from concurrently.
+ *
+ *        The range boundaries are stored in a skip list. Lookups take no lock: they search the
+ *        skip list and only start over if the boundary they end on was removed meanwhile.
+ *        'assign()' locks just the nodes it changes, which are the predecessors of 'keyBegin'
+ *        on each level and the boundaries inside the range, so assignments to different parts
+ *        of the key space run in parallel and only assignments to the same region wait for
+ *        each other.
+ *
+ *        An assignment builds the new boundaries at 'keyBegin' and 'keyEnd' aside, already
+ *        merged with equal neighbours, and links them in place of the boundaries inside the
+ *        range by changing a single pointer of the bottom list. Readers therefore see each
+ *        assignment either completely or not at all, and never a torn or half coalesced state.
+ *        Removed nodes are freed once every operation that could still reach them has ended
+ *        (epoch based reclamation).
+ *
+ * @tparam K  The key type, must be copyable, assignable and less-than comparable via operator<
+ * @tparam V  The value type, must be copyable, assignable and equality-comparable via operator==
+ */
+template<typename K, typename V>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V>
+class ConcurrentRangeMap
+{
+  public:
+    /**
+     * @brief Construct a new Concurrent Range Map object where the whole range of K
+     *        is associated with value 'defaultVal'.
+     */
+    ConcurrentRangeMap( V const& defaultVal )
+    : mDefaultVal { defaultVal }
+    {}
+
+
+
+    /**
+     * @brief Frees all boundaries. No other thread may use the container anymore.
+     */
+    ~ConcurrentRangeMap();
+
+
+
+    ConcurrentRangeMap( ConcurrentRangeMap const& )            = delete;
+    ConcurrentRangeMap& operator=( ConcurrentRangeMap const& ) = delete;
+
+
+
+    /**
+     * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[, overwriting any previous
+     *        values which overlap with this range. Ranges where 'keyEnd' is not greater
+     *        than 'keyBegin' are ignored. The assignment becomes visible to all threads
+     *        at once. The runtime for this call is expected O(log N + k), where k is the
+     *        number of boundaries inside the range, plus waiting for assignments to the
+     *        neighbouring boundaries.
+     *
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range. Note that the range excludes 'keyEnd'.
+     * @param keyVal    The value to associate to the range ['keyBegin', 'keyEnd'[
+     */
+    void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key' in expected O(log N), without
+     *        taking a lock. The value is returned by copy, since the boundary it was read
+     *        from can be removed by a concurrent assignment.
+     */
+    V operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Returns a copy of the ranges at a single point in time, in O(N log N). Use it to
+     *        do several lookups that must observe the same state. The boundaries are read
+     *        without a lock and read again if an assignment changed them meanwhile, so on a
+     *        large container that is assigned to all the time this can take several passes.
+     */
+    PersistentRangeMap<K,V> snapshot() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the nodes of the skip list, including removed nodes that
+     *        are not freed yet, which are counted as 'nodeBytes'. Concurrent assignments may or
+     *        may not be counted. The runtime is O(N).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+  private:
+    static constexpr std::size_t MaxHeight    { 16 }; // Levels of the skip list, each holds about a quarter of the nodes of the level below
+    static constexpr std::size_t NumStripes   { 64 }; // Threads are spread over this many sets of epoch counters
+    static constexpr std::size_t ReclaimBatch { 64 }; // Removed nodes of a stripe that trigger an attempt to free them
+
+    struct Node;
+
+    // The part of a node that links it into the lists, shared with the head of the lists
+    struct Link
+    {
+        explicit Link( std::size_t height_ )
+        : height { height_ }
+        , next   { std::make_unique<std::atomic<Node*>[]>( height_ ) }
+        {}
+
+        const std::size_t                     height;
+        std::unique_ptr<std::atomic<Node*>[]> next;              // Successor on each level the node is on
+        std::atomic<bool>                     marked  { false }; // Set when the node is removed, never cleared
+        std::atomic<std::uint64_t>            changes { 0 };     // Odd while 'next[0]' is being changed
+        std::mutex                            mutex;             // Held by the assignment that changes the node
+    };
+
+    struct Node : Link
+    {
+        Node( K const& key_, V const& value_, std::size_t height_ )
+        : Link  { height_ }
+        , key   { key_ }
+        , value { value_ }
+        {}
+
+        const K key;   // Start of the range
+        const V value; // Value of the range, which lasts until the next node
+    };
+
+    // Operations in progress and removed nodes of the threads that use one stripe
+    struct alignas(64) Stripe
+    {
+        std::array<std::atomic<std::uint64_t>, 3>    active {}; // Operations in progress, by their epoch modulo 3
+        std::mutex                                   retiredMutex;
+        std::vector<std::pair<std::uint64_t, Node*>> retired;   // Removed nodes and the epoch they were removed in
+    };
+
+    // Registers an operation in the current epoch, so that the nodes it reaches are not freed before it ends
+    class EpochGuard
+    {
+      public:
+        explicit EpochGuard( ConcurrentRangeMap const& map )
+        : mStripe { map.mStripes[StripeIndex()] }
+        {
+            // an operation that registers after the epoch moved on could miss a removal it must see
+            while( true )
+            {
+                mEpoch = map.mEpoch.load();
+                mStripe.active[mEpoch % 3].fetch_add( 1 );
+                if( map.mEpoch.load() == mEpoch )
+                {
+                    break;
+                }
+                mStripe.active[mEpoch % 3].fetch_sub( 1 );
+            }
+        }
+
+        ~EpochGuard()
+        {
+            mStripe.active[mEpoch % 3].fetch_sub( 1 );
+        }
+
+        EpochGuard( EpochGuard const& )            = delete;
+        EpochGuard& operator=( EpochGuard const& ) = delete;
+
+      private:
+        Stripe&       mStripe;
+        std::uint64_t mEpoch { 0 };
+    };
+
+
+    /**
+     * @brief Returns the stripe of the calling thread. Threads are dealt to the stripes round-robin.
+     */
+    static std::size_t StripeIndex();
+
+
+    /**
+     * @brief Returns a random node height, where each level is four times less likely than the one below.
+     */
+    static std::size_t RandomHeight();
+
+
+    /**
+     * @brief Returns the value of the range that starts at 'link', the default value for the head.
+     */
+    V const& ValueOf( Link const* link ) const;
+
+
+    /**
+     * @brief Fills 'preds' with the last link before 'key' on every level, and 'succs' with the node after it.
+     */
+    void FindPredecessors( K const& key, std::array<Link*, MaxHeight>& preds, std::array<Node*, MaxHeight>& succs );
+
+
+    /**
+     * @brief Does one attempt of 'assign()', for a range that is not empty.
+     *
+     * @param removed  Receives the removed nodes if the attempt succeeded.
+     * @return         false if another assignment changed the nodes around the range first.
+     */
+    bool TryAssign( K const& keyBegin, K const& keyEnd, V const& keyVal, std::vector<Node*>& removed );
+
+
+    /**
+     * @brief Hands removed nodes over to be freed once no operation can reach them anymore.
+     */
+    void Retire( std::vector<Node*> const& nodes );
+
+
+    /**
+     * @brief Moves to the next epoch if no operation of the previous one is still in progress.
+     */
+    void TryAdvanceEpoch();
+
+
+    // Member variables
+    const V                                mDefaultVal;                // Default value for values of 'K' that fall outside ranges
+    Link                                   mHead       { MaxHeight };  // Head of the lists, its range holds the default value
+    mutable std::array<Stripe, NumStripes> mStripes;
+    std::atomic<std::uint64_t>             mEpoch      { 0 };          // Nodes removed in epoch e are freed from epoch e + 2 on
+};
+
+
+
+
+template<typename K, typename V>
+ConcurrentRangeMap<K,V>::~ConcurrentRangeMap()
+{
+    for( Node* node { mHead.next[0].load() }; node; )
+    {
+        Node* next { node->next[0].load() };
+        delete node;
+        node = next;
+    }
+
+    for( Stripe& stripe : mStripes )
+    {
+        for( auto const& entry : stripe.retired )
+        {
+            delete entry.second;
+        }
+    }
+}
+
+
+
+template<typename K, typename V>
+void ConcurrentRangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // ignore invalid range
+    if( !(keyBegin < keyEnd) )
+    {
+        return;
+    }
+
+    std::vector<Node*> removed;
+    {
+        const EpochGuard guard { *this };
+        while( !TryAssign( keyBegin, keyEnd, keyVal, removed ) )
+        {
+        }
+    }
+
+    Retire( removed );
+}
+
+
+
+template<typename K, typename V>
+V ConcurrentRangeMap<K,V>::operator[]( K const& key ) const
+{
+    const EpochGuard guard { *this };
+
+    while( true )
+    {
+        Link const* link { &mHead };
+        for( std::size_t level{MaxHeight}; level-- > 0; )
+        {
+            Node const* next { link->next[level].load() };
+            while( next && !(key < next->key) )
+            {
+                link = next;
+                next = link->next[level].load();
+            }
+        }
+
+        // The last read of 'link->next[0]' found no boundary up to 'key'. If 'link' is still
+        // not removed, it was in the list at that time, so it held the value of 'key'.
+        if( !link->marked.load() )
+        {
+            return ValueOf( link );
+        }
+    }
+}
+
+
+
+template<typename K, typename V>
+PersistentRangeMap<K,V> ConcurrentRangeMap<K,V>::snapshot() const
+{
+    const EpochGuard guard { *this };
+
+    std::vector<std::pair<Link const*, std::uint64_t>> visited; // links and their 'changes' when 'next[0]' was read
+
+    bool isConsistent { false };
+    while( !isConsistent )
+    {
+        visited.clear();
+        isConsistent = true;
+
+        for( Link const* link { &mHead }; link && isConsistent; link = link->next[0].load() )
+        {
+            const std::uint64_t changes { link->changes.load() };
+            isConsistent = changes % 2 == 0;
+            visited.emplace_back( link, changes );
+        }
+
+        // If no link was removed and no successor changed since it was read, the list held
+        // exactly these links between the end of the reads and the start of the checks
+        isConsistent = isConsistent && std::all_of( visited.begin(), visited.end(), []( auto const& entry )
+        {
+            return !entry.first->marked.load() && entry.first->changes.load() == entry.second;
+        });
+    }
+
+    // Each range lasts until the next boundary, and the last boundary holds the default value
+    PersistentRangeMap<K,V> result { mDefaultVal };
+    for( std::size_t index{1}; index + 1 < visited.size(); ++index )
+    {
+        Node const* node { static_cast<Node const*>( visited[index].first ) };
+        Node const* next { static_cast<Node const*>( visited[index + 1].first ) };
+        result.assign( node->key, next->key, node->value );
+    }
+
+    return result;
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage ConcurrentRangeMap<K,V>::memory_usage() const
+{
+    auto linkBytes = []( Node const* node )
+    {
+        return sizeof(Node) + node->height * sizeof(std::atomic<Node*>);
+    };
+
+    RangeMapMemoryUsage usage;
+    {
+        const EpochGuard guard { *this };
+        for( Node const* node { mHead.next[0].load() }; node; node = node->next[0].load() )
+        {
+            ++usage.boundaries;
+            usage.nodeBytes  += linkBytes( node ) - sizeof(K) - sizeof(V);
+            usage.keyBytes   += ObjectBytes( node->key );
+            usage.valueBytes += ObjectBytes( node->value );
+        }
+    }
+
+    for( Stripe& stripe : mStripes )
+    {
+        std::lock_guard lock { stripe.retiredMutex };
+
+        usage.nodeBytes += stripe.retired.capacity() * sizeof(stripe.retired[0]);
+        for( auto const& entry : stripe.retired )
+        {
+            usage.nodeBytes += linkBytes( entry.second ) + RangeMapHeapBytes<K>{}( entry.second->key ) +
+                                                           RangeMapHeapBytes<V>{}( entry.second->value );
+        }
+    }
+
+    return usage;
+}
+
+
+
+template<typename K, typename V>
+std::size_t ConcurrentRangeMap<K,V>::StripeIndex()
+{
+    static std::atomic<std::size_t>    sNextIndex { 0 };
+    static thread_local const std::size_t index  { sNextIndex.fetch_add( 1 ) % NumStripes };
+
+    return index;
+}
+
+
+
+template<typename K, typename V>
+std::size_t ConcurrentRangeMap<K,V>::RandomHeight()
+{
+    static thread_local std::minstd_rand gen { std::random_device{}() };
+    std::uniform_int_distribution<int>   distLevel( 0, 3 );
+
+    std::size_t height { 1 };
+    while( height < MaxHeight && distLevel(gen) == 0 )
+    {
+        ++height;
+    }
+
+    return height;
+}
+
+
+
+template<typename K, typename V>
+V const& ConcurrentRangeMap<K,V>::ValueOf( Link const* link ) const
+{
+    return link == &mHead ? mDefaultVal : static_cast<Node const*>( link )->value;
+}
+
+
+
+template<typename K, typename V>
+void ConcurrentRangeMap<K,V>::FindPredecessors( K const& key, std::array<Link*, MaxHeight>& preds, std::array<Node*, MaxHeight>& succs )
+{
+    Link* link { &mHead };
+    for( std::size_t level{MaxHeight}; level-- > 0; )
+    {
+        Node* next { link->next[level].load() };
+        while( next && next->key < key )
+        {
+            link = next;
+            next = link->next[level].load();
+        }
+
+        preds[level] = link;
+        succs[level] = next;
+    }
+}
+
+
+
+template<typename K, typename V>
+bool ConcurrentRangeMap<K,V>::TryAssign( K const& keyBegin, K const& keyEnd, V const& keyVal, std::vector<Node*>& removed )
+{
+    std::array<Link*, MaxHeight> preds;
+    std::array<Node*, MaxHeight> succs;
+    FindPredecessors( keyBegin, preds, succs );
+
+    // The boundaries in ['keyBegin', 'keyEnd'] are replaced. 'last' is the link whose range
+    // reaches 'keyEnd', and 'after' the first boundary that is kept after the range.
+    std::vector<Node*> inside;
+    Link*              last  { preds[0] };
+    Node*              after { succs[0] };
+    while( after && !(keyEnd < after->key) )
+    {
+        inside.push_back( after );
+        last  = after;
+        after = after->next[0].load();
+    }
+
+    V const& valueBefore { ValueOf( preds[0] ) };
+    V const& valueAtEnd  { ValueOf( last ) };
+
+    // nothing to do if the whole range already holds 'keyVal'
+    if( inside.empty() && valueBefore == keyVal && !preds[0]->marked.load() )
+    {
+        return true;
+    }
+
+    // the new boundaries are only needed where the value changes
+    std::unique_ptr<Node> first  { valueBefore == keyVal ? nullptr : std::make_unique<Node>( keyBegin, keyVal,     RandomHeight() ) };
+    std::unique_ptr<Node> second { valueAtEnd  == keyVal ? nullptr : std::make_unique<Node>( keyEnd,   valueAtEnd, RandomHeight() ) };
+
+    std::size_t height { std::max( first ? first->height : 1, second ? second->height : 1 ) };
+    for( Node* node : inside )
+    {
+        height = std::max( height, node->height );
+    }
+
+    // Lock in key order, so that assignments that overlap cannot deadlock. The predecessors
+    // are ordered from the top level down, and a predecessor can be shared by several levels.
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve( height + inside.size() + 2 );
+    for( std::size_t level{height}; level-- > 0; )
+    {
+        if( level + 1 == height || preds[level] != preds[level + 1] )
+        {
+            locks.emplace_back( preds[level]->mutex );
+        }
+    }
+    for( Node* node : inside )
+    {
+        locks.emplace_back( node->mutex );
+    }
+
+    // check that no other assignment changed the nodes between finding and locking them
+    for( std::size_t level{0}; level < height; ++level )
+    {
+        if( preds[level]->marked.load() || preds[level]->next[level].load() != succs[level] )
+        {
+            return false;
+        }
+    }
+
+    Node* expected { succs[0] };
+    for( Node* node : inside )
+    {
+        if( node != expected || node->marked.load() )
+        {
+            return false;
+        }
+        expected = node->next[0].load();
+    }
+    if( expected != after )
+    {
+        return false;
+    }
+
+    // Link the new nodes to the first node after the range on each level. The locked nodes
+    // are all the nodes in the range, so the nodes after it cannot be removed meanwhile.
+    std::array<Node*, MaxHeight> targets;
+    for( std::size_t level{0}; level < height; ++level )
+    {
+        Node* target { succs[level] };
+        while( target && !(keyEnd < target->key) )
+        {
+            target = target->next[level].load();
+        }
+
+        if( second && level < second->height )
+        {
+            second->next[level].store( target );
+            target = second.get();
+        }
+        if( first && level < first->height )
+        {
+            first->next[level].store( target );
+            target = first.get();
+        }
+        targets[level] = target;
+    }
+
+    // the new nodes are locked until they are linked on all levels
+    for( Node* node : { first.get(), second.get() } )
+    {
+        if( node )
+        {
+            locks.emplace_back( node->mutex );
+        }
+    }
+
+    for( Node* node : inside )
+    {
+        node->marked.store( true );
+    }
+
+    // publish the assignment, 'snapshot()' rereads a successor that changes meanwhile
+    preds[0]->changes.fetch_add( 1 );
+    preds[0]->next[0].store( targets[0] );
+    preds[0]->changes.fetch_add( 1 );
+
+    for( std::size_t level{1}; level < height; ++level )
+    {
+        preds[level]->next[level].store( targets[level] );
+    }
+
+    first.release();
+    second.release();
+    removed = std::move( inside );
+
+    return true;
+}
+
+
+
+template<typename K, typename V>
+void ConcurrentRangeMap<K,V>::Retire( std::vector<Node*> const& nodes )
+{
+    if( nodes.empty() )
+    {
+        return;
+    }
+
+    Stripe& stripe { mStripes[StripeIndex()] };
+    std::lock_guard lock { stripe.retiredMutex };
+
+    // the nodes are unlinked, so operations that start from now on cannot reach them
+    const std::uint64_t epoch { mEpoch.load() };
+    for( Node* node : nodes )
+    {
+        stripe.retired.emplace_back( epoch, node );
+    }
+
+    if( stripe.retired.size() < ReclaimBatch )
+    {
+        return;
+    }
+
+    TryAdvanceEpoch();
+
+    // the nodes are ordered by the epoch they were removed in
+    const std::uint64_t current { mEpoch.load() };
+    auto const          end     = std::find_if( stripe.retired.begin(), stripe.retired.end(),
+                                                [current]( auto const& entry ){ return current < entry.first + 2; } );
+    for( auto it = stripe.retired.begin(); it != end; ++it )
+    {
+        delete it->second;
+    }
+    stripe.retired.erase( stripe.retired.begin(), end );
+}
+
+
+
+template<typename K, typename V>
+void ConcurrentRangeMap<K,V>::TryAdvanceEpoch()
+{
+    std::uint64_t epoch { mEpoch.load() };
+
+    // Operations of the previous epoch may still reach nodes removed in it. Operations of
+    // the current epoch may keep running, since epoch e + 1 does not free the nodes of e yet.
+    for( Stripe const& stripe : mStripes )
+    {
+        if( stripe.active[(epoch + 2) % 3].load() != 0 )
+        {
+            return;
+        }
+    }
+
+    mEpoch.compare_exchange_strong( epoch, epoch + 1 );
+}
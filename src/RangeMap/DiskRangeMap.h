@@ -0,0 +1,1471 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/MemoryUsage.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A file of fixed size pages, read and written with 'pread()' and 'pwrite()'.
+ *        Errors are reported by throwing 'std::system_error'.
+ */
+class DiskPageFile
+{
+  public:
+    static constexpr std::size_t PageSize { 4096 };
+
+    using Page = std::array<std::byte, PageSize>;
+
+
+    /**
+     * @brief Opens the file at 'path', creating it if it does not exist.
+     */
+    explicit DiskPageFile( std::string const& path )
+    : mFd { ::open( path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644 ) }
+    {
+        if( mFd < 0 )
+        {
+            throw std::system_error( errno, std::generic_category(), "DiskPageFile: cannot open '" + path + "'" );
+        }
+    }
+
+
+    DiskPageFile( DiskPageFile const& ) = delete;
+    DiskPageFile& operator=( DiskPageFile const& ) = delete;
+
+
+    ~DiskPageFile()
+    {
+        ::close( mFd );
+    }
+
+
+    /**
+     * @brief Returns the number of whole pages in the file.
+     */
+    std::uint64_t page_count() const
+    {
+        struct stat info;
+        if( ::fstat( mFd, &info ) != 0 )
+        {
+            throw std::system_error( errno, std::generic_category(), "DiskPageFile: fstat failed" );
+        }
+
+        return std::uint64_t( info.st_size ) / PageSize;
+    }
+
+
+    /**
+     * @brief Reads page 'id' into 'page'. Bytes beyond the end of the file read as zero.
+     */
+    void read( std::uint64_t id, Page& page ) const
+    {
+        std::size_t done { 0 };
+        while( done < PageSize )
+        {
+            const ssize_t count { ::pread( mFd, page.data() + done, PageSize - done, off_t( id * PageSize + done ) ) };
+            if( count < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if( count < 0 )
+            {
+                throw std::system_error( errno, std::generic_category(), "DiskPageFile: read failed" );
+            }
+            if( count == 0 )
+            {
+                std::fill( page.begin() + std::ptrdiff_t(done), page.end(), std::byte{0} );
+                return;
+            }
+            done += std::size_t( count );
+        }
+    }
+
+
+    /**
+     * @brief Writes 'page' to page 'id', growing the file if needed.
+     */
+    void write( std::uint64_t id, Page const& page )
+    {
+        std::size_t done { 0 };
+        while( done < PageSize )
+        {
+            const ssize_t count { ::pwrite( mFd, page.data() + done, PageSize - done, off_t( id * PageSize + done ) ) };
+            if( count < 0 && errno == EINTR )
+            {
+                continue;
+            }
+            if( count <= 0 )
+            {
+                throw std::system_error( errno, std::generic_category(), "DiskPageFile: write failed" );
+            }
+            done += std::size_t( count );
+        }
+    }
+
+
+    /**
+     * @brief Returns once all written pages are on stable storage.
+     */
+    void sync()
+    {
+        if( ::fsync( mFd ) != 0 )
+        {
+            throw std::system_error( errno, std::generic_category(), "DiskPageFile: fsync failed" );
+        }
+    }
+
+
+  private:
+    // Member variables
+    int mFd; // File descriptor
+};
+
+
+
+/**
+ * @brief Page reads and writes done by a DiskBufferPool, as reported by 'DiskRangeMap::io_stats()'.
+ */
+struct DiskIoStats
+{
+    std::uint64_t pageReads  { 0 }; // Pages read from the file, on a miss in the buffer pool
+    std::uint64_t pageWrites { 0 }; // Pages written to the file, on eviction or on a flush
+};
+
+
+
+/**
+ * @brief Caches up to 'capacity' pages of a DiskPageFile and evicts the least recently used
+ *        one when full. Changed pages are only written to the file when they are evicted or
+ *        flushed.
+ */
+class DiskBufferPool
+{
+  public:
+    using Page = DiskPageFile::Page;
+
+
+    DiskBufferPool( DiskPageFile& file, std::size_t capacity )
+    : mFile     { file }
+    , mCapacity { std::max( capacity, std::size_t(1) ) }
+    {}
+
+
+    /**
+     * @brief Returns page 'id'. The reference is valid until the next call to the pool.
+     */
+    Page const& read( std::uint64_t id )
+    {
+        return Fetch( id, true ).page;
+    }
+
+
+    /**
+     * @brief Returns page 'id' for writing. The reference is valid until the next call to the pool.
+     */
+    Page& write( std::uint64_t id )
+    {
+        Frame& frame { Fetch( id, true ) };
+        frame.dirty = true;
+        return frame.page;
+    }
+
+
+    /**
+     * @brief Same as 'write()', for a page whose previous content is not needed, so it is not read.
+     */
+    Page& create( std::uint64_t id )
+    {
+        Frame& frame { Fetch( id, false ) };
+        frame.dirty = true;
+        return frame.page;
+    }
+
+
+    /**
+     * @brief Forgets page 'id' without writing it, for pages that are no longer used.
+     */
+    void drop( std::uint64_t id )
+    {
+        auto it = mIndex.find( id );
+        if( it != mIndex.end() )
+        {
+            mFrames.erase( it->second );
+            mIndex.erase( it );
+        }
+    }
+
+
+    /**
+     * @brief Writes all changed pages to the file.
+     */
+    void flush()
+    {
+        for( Frame& frame : mFrames )
+        {
+            if( frame.dirty )
+            {
+                mFile.write( frame.id, frame.page );
+                frame.dirty = false;
+                ++mStats.pageWrites;
+            }
+        }
+    }
+
+
+    std::size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+
+    DiskIoStats const& stats() const
+    {
+        return mStats;
+    }
+
+
+  private:
+    struct Frame
+    {
+        std::uint64_t                     id;
+        bool                              dirty;
+        alignas(std::max_align_t) Page    page;
+    };
+
+
+    /**
+     * @brief Moves page 'id' to the front of the LRU list, loading it from the file if it
+     *        is not cached and 'load' is set, or zeroing it otherwise.
+     */
+    Frame& Fetch( std::uint64_t id, bool load )
+    {
+        auto it = mIndex.find( id );
+        if( it != mIndex.end() )
+        {
+            mFrames.splice( mFrames.begin(), mFrames, it->second );
+            return mFrames.front();
+        }
+
+        // reuse the least recently used frame when full
+        if( mFrames.size() >= mCapacity )
+        {
+            Frame& victim { mFrames.back() };
+            if( victim.dirty )
+            {
+                mFile.write( victim.id, victim.page );
+                ++mStats.pageWrites;
+            }
+            mIndex.erase( victim.id );
+            mFrames.splice( mFrames.begin(), mFrames, std::prev( mFrames.end() ) );
+        }
+        else
+        {
+            mFrames.emplace_front();
+        }
+
+        Frame& frame { mFrames.front() };
+        frame.id    = id;
+        frame.dirty = false;
+
+        if( load )
+        {
+            mFile.read( id, frame.page );
+            ++mStats.pageReads;
+        }
+        else
+        {
+            frame.page.fill( std::byte{0} );
+        }
+
+        mIndex[id] = mFrames.begin();
+        return frame;
+    }
+
+
+    // Member variables
+    DiskPageFile&                                                     mFile;      // File the pages are read from and written to
+    std::size_t                                                       mCapacity;  // Maximum number of cached pages
+    std::list<Frame>                                                  mFrames;    // Cached pages, most recently used first
+    std::unordered_map<std::uint64_t, typename std::list<Frame>::iterator> mIndex; // Frame of each cached page
+    DiskIoStats                                                       mStats;     // Page reads and writes so far
+};
+
+
+
+/**
+ * @brief A range map stored in a file, for maps larger than the available memory. The range
+ *        boundaries are kept in a B+tree of 4 KiB pages, of which only the pages in an LRU
+ *        buffer pool of 'poolPages' pages are held in memory. 'assign()' and 'operator[]'
+ *        have the same canonical semantics as RangeMap and read O(log N) pages.
+ *
+ *        Pages are never changed in place once they are part of a committed version: a
+ *        change copies the pages on the path to the root, and 'sync()' commits the new root
+ *        by writing one of two alternating superblocks, after the pages it points to are on
+ *        stable storage. After a crash, or when the map is destroyed, the file is opened at
+ *        the last committed version, and changes since then are lost. Pages replaced by a
+ *        change are reused once the change is committed.
+ *
+ *        Keys and values are stored as raw bytes, so the file can only be opened on machines
+ *        with the same layout for them. The container is not thread-safe.
+ *
+ * @tparam K  The key type, must be trivially copyable, default constructible and less-than comparable via operator<
+ * @tparam V  The value type, must be trivially copyable, default constructible and equality-comparable via operator==
+ */
+template<typename K, typename V>
+    requires std::is_trivially_copyable<K>::value &&
+             std::is_default_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_trivially_copyable<V>::value &&
+             std::is_default_constructible<V>::value &&
+                  is_equality_comparable<V>
+class DiskRangeMap
+{
+  public:
+    /**
+     * @brief Opens the Disk Range Map stored in file 'path' at its last committed version, or
+     *        creates a new one where the whole range of K is associated with value 'defaultVal'
+     *        if the file is new or holds no committed version. An existing map keeps its own
+     *        default value. Throws 'std::runtime_error' if the file was written with other
+     *        key or value types, and 'std::system_error' if it cannot be read.
+     *
+     * @param path        The file holding the map.
+     * @param defaultVal  The default value of a new map.
+     * @param poolPages   The number of pages kept in memory.
+     */
+    DiskRangeMap( std::string const& path, V const& defaultVal, std::size_t poolPages = 256 );
+
+
+
+    DiskRangeMap( DiskRangeMap const& ) = delete;
+    DiskRangeMap& operator=( DiskRangeMap const& ) = delete;
+
+
+
+    /**
+     * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[, overwriting any previous
+     *        values which overlap with this range. Ranges where 'keyEnd' is not greater
+     *        than 'keyBegin' are ignored. The change is durable after the next 'sync()'.
+     *
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range. Note that the range excludes 'keyEnd'.
+     * @param keyVal    The value to associate to the range ['keyBegin', 'keyEnd'[
+     */
+    void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key'. The value is returned by copy,
+     *        since the page it was read from can be evicted by the next lookup.
+     */
+    V operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Commits all changes so far: writes the changed pages, then the superblock pointing
+     *        to them, waiting for each to reach stable storage.
+     */
+    void sync();
+
+
+
+    /**
+     * @brief Returns the number of stored range boundaries.
+     */
+    std::size_t size() const;
+
+
+
+    /**
+     * @brief Calls 'fn(key, value)' for every stored range boundary, in key order.
+     */
+    template<typename F>
+    void for_each( F&& fn ) const;
+
+
+
+    /**
+     * @brief Returns the stored range boundaries as a 'std::map', in the layout used
+     *        by 'RangeMap::data()'. The runtime is O(N).
+     */
+    std::map<K,V> to_map() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the buffer pool and the free page lists, as extra
+     *        bytes. The boundaries themselves are on disk.
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+    /**
+     * @brief Returns the pages read from and written to the file so far.
+     */
+    DiskIoStats io_stats() const;
+
+
+
+  private:
+    static constexpr std::size_t   PageSize { DiskPageFile::PageSize };
+    static constexpr std::uint64_t Magic    { 0x52616e67654d6170 }; // "RangeMap"
+    static constexpr std::uint64_t NoPage   { 0 };                  // Pages 0 and 1 hold the superblocks
+
+    struct PageHeader
+    {
+        std::uint32_t isLeaf;
+        std::uint32_t count;
+    };
+
+    // A few bytes are left for padding between the members
+    static constexpr std::size_t LeafCapacity  { (PageSize - 64) / (sizeof(K) + sizeof(V)) };
+    static constexpr std::size_t InnerCapacity { (PageSize - 64) / (sizeof(K) + sizeof(std::uint64_t)) };
+
+    static_assert( LeafCapacity >= 4 && InnerCapacity >= 4, "DiskRangeMap: keys and values must fit a page several times" );
+
+    struct LeafPage
+    {
+        PageHeader                     header;
+        std::array<K, LeafCapacity>    keys;
+        std::array<V, LeafCapacity>    values;
+    };
+
+    // 'keys[i]' is not greater than the keys in child 'i', and greater than those in child 'i-1'
+    struct InnerPage
+    {
+        PageHeader                                 header;
+        std::array<K, InnerCapacity>               keys;
+        std::array<std::uint64_t, InnerCapacity>   children;
+    };
+
+    struct Superblock
+    {
+        std::uint64_t checksum;   // Of the bytes after it
+        std::uint64_t magic;
+        std::uint64_t generation; // Incremented by every commit, the valid superblock with the highest one is used
+        std::uint64_t root;       // Root page, 'NoPage' if there are no ranges
+        std::uint64_t height;     // Levels of the tree, 1 if the root is a leaf
+        std::uint64_t pageCount;  // Pages in use by this version, including free ones
+        std::uint64_t size;       // Number of stored range boundaries
+        std::uint32_t keySize;
+        std::uint32_t valueSize;
+        V             defaultVal;
+    };
+
+    static_assert( sizeof(LeafPage) <= PageSize && sizeof(InnerPage) <= PageSize && sizeof(Superblock) <= PageSize );
+    static_assert( alignof(LeafPage) <= alignof(std::max_align_t) && alignof(InnerPage) <= alignof(std::max_align_t) );
+
+
+    struct InsertResult
+    {
+        std::uint64_t                                  page;  // The updated page
+        std::optional<std::pair<K, std::uint64_t>>     split; // The first key and page of the new right sibling, if it was split
+    };
+
+
+    /**
+     * @brief Loads the superblock of the last committed version, if there is one.
+     */
+    void Open();
+
+
+    /**
+     * @brief Returns a copy of page 'id', read as a 'P'.
+     */
+    template<typename P>
+    P Load( std::uint64_t id ) const;
+
+
+    /**
+     * @brief Returns page 'id', read as a 'P' in place in the buffer pool. The reference is
+     *        valid until the next call to the pool. Throws 'std::runtime_error' if the page
+     *        is not a valid 'P'.
+     */
+    template<typename P>
+    P const& View( std::uint64_t id ) const;
+
+
+    bool IsLeaf( std::uint64_t id ) const;
+
+
+    /**
+     * @brief Stores 'page' as the new content of page 'id', or of a new page if 'id' is
+     *        'NoPage'. Pages of the committed version are copied, others changed in place.
+     *
+     * @return  The page now holding 'page'.
+     */
+    template<typename P>
+    std::uint64_t Store( std::uint64_t id, P const& page );
+
+
+    std::uint64_t AllocatePage();
+    void          ReleasePage( std::uint64_t id );
+    bool          IsFresh( std::uint64_t id ) const;
+
+
+    /**
+     * @brief Returns the index of the child of 'inner' whose keys range holds 'key'.
+     */
+    static std::size_t ChildIndex( InnerPage const& inner, K const& key );
+
+
+    /**
+     * @brief Returns the last boundary below page 'id' with a key less than 'key', or not
+     *        greater than 'key' if 'inclusive' is set.
+     */
+    std::optional<std::pair<K,V>> FindLast( std::uint64_t id, K const& key, bool inclusive ) const;
+
+
+    /**
+     * @brief Inserts or updates boundary 'key' below page 'id'.
+     */
+    InsertResult Insert( std::uint64_t id, K const& key, V const& value );
+
+
+    /**
+     * @brief Removes the boundaries below page 'id' with keys in ['lo', 'hi'[, or in
+     *        ['lo', 'hi'] if 'inclusive' is set.
+     *
+     * @return  The updated page, or nothing if no boundaries are left below it.
+     */
+    std::optional<std::uint64_t> EraseRange( std::uint64_t id, K const& lo, K const& hi, bool inclusive );
+
+
+    /**
+     * @brief Merges child 'index' of 'parent' with the next child, if one of them is less
+     *        than half full and they fit in a single page.
+     */
+    void MergeChildren( InnerPage& parent, std::size_t index );
+
+
+    /**
+     * @brief Merges the pages of type 'P' of child 'index' of 'parent' and the next child,
+     *        where 'Entries' are the values or children stored next to the keys.
+     *
+     * @return  true if they were merged.
+     */
+    template<typename P, std::size_t Capacity, auto Entries>
+    bool MergePages( InnerPage& parent, std::size_t index );
+
+
+    /**
+     * @brief Releases page 'id' and all pages below it.
+     *
+     * @return  The number of boundaries that were stored below it.
+     */
+    std::size_t ReleaseSubtree( std::uint64_t id );
+
+
+    void InsertAtRoot( K const& key, V const& value );
+    void EraseAtRoot( K const& lo, K const& hi, bool inclusive );
+
+
+    template<typename F>
+    void ForEach( std::uint64_t id, F& fn ) const;
+
+
+    static std::uint64_t Checksum( Superblock const& block );
+
+
+    // Member variables
+    DiskPageFile               mFile;                   // The file holding the pages
+    mutable DiskBufferPool     mPool;                   // Pages cached in memory
+    V                          mDefaultVal;             // Default value for values of 'K' that fall outside ranges
+    std::uint64_t              mRoot       { NoPage };  // Root page of the tree
+    std::uint64_t              mHeight     { 0 };       // Levels of the tree, 0 if it is empty
+    std::uint64_t              mPageCount  { 2 };       // Pages allocated in the file
+    std::size_t                mSize       { 0 };       // Number of stored range boundaries
+    std::uint64_t              mGeneration { 0 };       // Generation of the last committed superblock
+    std::vector<std::uint64_t> mFree;                   // Pages that can be reused
+    std::vector<std::uint64_t> mPendingFree;            // Pages of the committed version that are reused after the next commit
+    std::vector<std::uint64_t> mFreshPages;             // Pages allocated since the last commit, some may be released again
+    std::vector<bool>          mIsFresh;                // Whether each page was allocated since the last commit
+};
+
+
+
+
+template<typename K, typename V>
+DiskRangeMap<K,V>::DiskRangeMap( std::string const& path, V const& defaultVal, std::size_t poolPages )
+: mFile       { path }
+, mPool       { mFile, poolPages }
+, mDefaultVal { defaultVal }
+{
+    Open();
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // ignore invalid range
+    if( !(keyBegin < keyEnd) )
+    {
+        return;
+    }
+
+    const auto beforeBegin = FindLast( mRoot, keyBegin, false );
+    const auto atEnd       = FindLast( mRoot, keyEnd,   true  );
+
+    V const valueBeforeBegin { beforeBegin ? beforeBegin->second : mDefaultVal };
+    V const valueAtEnd       { atEnd       ? atEnd->second       : mDefaultVal };
+
+    // remove the boundaries covered by the new range, and the one at 'keyEnd' if the new
+    // range is extended by the range after it
+    const bool isRangeStartingAtKeyEnd { atEnd && !(atEnd->first < keyEnd) };
+    EraseAtRoot( keyBegin, keyEnd, isRangeStartingAtKeyEnd && valueAtEnd == keyVal );
+
+    // insert 'keyBegin', unless the previous range is extended
+    if( !(valueBeforeBegin == keyVal) )
+    {
+        InsertAtRoot( keyBegin, keyVal );
+    }
+
+    // insert 'keyEnd', continuing the range the new range was placed on top of
+    if( !isRangeStartingAtKeyEnd && !(valueAtEnd == keyVal) )
+    {
+        InsertAtRoot( keyEnd, valueAtEnd );
+    }
+}
+
+
+
+template<typename K, typename V>
+V DiskRangeMap<K,V>::operator[]( K const& key ) const
+{
+    const auto boundary = FindLast( mRoot, key, true );
+
+    return boundary ? boundary->second : mDefaultVal;
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::sync()
+{
+    mPool.flush();
+    mFile.sync();
+
+    DiskPageFile::Page page {};
+
+    Superblock block;
+    std::memset( static_cast<void*>(&block), 0, sizeof(block) );
+    block.magic      = Magic;
+    block.generation = mGeneration + 1;
+    block.root       = mRoot;
+    block.height     = mHeight;
+    block.pageCount  = mPageCount;
+    block.size       = mSize;
+    block.keySize    = std::uint32_t( sizeof(K) );
+    block.valueSize  = std::uint32_t( sizeof(V) );
+    block.defaultVal = mDefaultVal;
+    block.checksum   = Checksum( block );
+    std::memcpy( page.data(), &block, sizeof(block) );
+
+    // alternate between the two superblocks, so the previous one stays intact if this write is torn
+    mFile.write( block.generation % 2, page );
+    mFile.sync();
+
+    mGeneration = block.generation;
+
+    mFree.insert( mFree.end(), mPendingFree.begin(), mPendingFree.end() );
+    mPendingFree.clear();
+
+    for( std::uint64_t id : mFreshPages )
+    {
+        mIsFresh[id] = false;
+    }
+    mFreshPages.clear();
+}
+
+
+
+template<typename K, typename V>
+std::size_t DiskRangeMap<K,V>::size() const
+{
+    return mSize;
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void DiskRangeMap<K,V>::for_each( F&& fn ) const
+{
+    if( mRoot != NoPage )
+    {
+        ForEach( mRoot, fn );
+    }
+}
+
+
+
+template<typename K, typename V>
+std::map<K,V> DiskRangeMap<K,V>::to_map() const
+{
+    std::map<K,V> out;
+
+    for_each( [&out]( K const& key, V const& value ) { out.emplace_hint( out.end(), key, value ); } );
+
+    return out;
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage DiskRangeMap<K,V>::memory_usage() const
+{
+    RangeMapMemoryUsage usage;
+
+    usage.boundaries = mSize;
+    usage.nodeBytes  = sizeof(*this);
+    usage.extraBytes = mPool.capacity() * (sizeof(DiskPageFile::Page) + 8 * sizeof(void*))
+                     + (mFree.capacity() + mPendingFree.capacity() + mFreshPages.capacity()) * sizeof(std::uint64_t)
+                     + mIsFresh.capacity() / 8;
+
+    return usage;
+}
+
+
+
+template<typename K, typename V>
+DiskIoStats DiskRangeMap<K,V>::io_stats() const
+{
+    return mPool.stats();
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::Open()
+{
+    // use the valid superblock with the highest generation
+    std::optional<Superblock> latest;
+
+    for( std::uint64_t id : { std::uint64_t(0), std::uint64_t(1) } )
+    {
+        DiskPageFile::Page page;
+        mFile.read( id, page );
+
+        Superblock block;
+        std::memcpy( static_cast<void*>(&block), page.data(), sizeof(block) );
+
+        if( block.magic != Magic || block.checksum != Checksum( block ) )
+        {
+            continue; // never written, or torn by a crash
+        }
+
+        if( block.keySize != sizeof(K) || block.valueSize != sizeof(V) )
+        {
+            throw std::runtime_error( "DiskRangeMap: the file holds keys or values of another size" );
+        }
+
+        if( !latest || latest->generation < block.generation )
+        {
+            latest = block;
+        }
+    }
+
+    if( !latest )
+    {
+        return;
+    }
+
+    if( latest->pageCount < 2 || (latest->root == NoPage) != (latest->height == 0) || latest->root >= latest->pageCount )
+    {
+        throw std::runtime_error( "DiskRangeMap: the file is corrupt, the superblock refers to a page outside of it" );
+    }
+
+    mDefaultVal = latest->defaultVal;
+    mRoot       = latest->root;
+    mHeight     = latest->height;
+    mPageCount  = latest->pageCount;
+    mSize       = std::size_t( latest->size );
+    mGeneration = latest->generation;
+    mIsFresh.assign( mPageCount, false );
+
+    // Pages that are not reachable from the root were replaced or never committed, so
+    // they are free. Only the inner pages need to be read to find all reachable pages.
+    std::vector<bool> isUsed( mPageCount, false );
+    isUsed[0] = isUsed[1] = true;
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> pending; // page and its height
+    if( mRoot != NoPage )
+    {
+        pending.emplace_back( mRoot, mHeight );
+    }
+
+    while( !pending.empty() )
+    {
+        const auto [id, height] = pending.back();
+        pending.pop_back();
+
+        // every page of a copy-on-write tree has a single parent, so this also stops cycles
+        if( id < 2 || id >= mPageCount || isUsed[id] )
+        {
+            throw std::runtime_error( "DiskRangeMap: the file is corrupt, a page refers to a page outside of the tree" );
+        }
+        isUsed[id] = true;
+
+        if( height > 1 )
+        {
+            // 'View()' checks the count of the page against its capacity
+            InnerPage const& inner { View<InnerPage>( id ) };
+            for( std::size_t index{0}; index < inner.header.count; ++index )
+            {
+                pending.emplace_back( inner.children[index], height - 1 );
+            }
+        }
+    }
+
+    for( std::uint64_t id{mPageCount}; id-- > 2; )
+    {
+        if( !isUsed[id] )
+        {
+            mFree.push_back( id );
+        }
+    }
+}
+
+
+
+template<typename K, typename V>
+template<typename P>
+P DiskRangeMap<K,V>::Load( std::uint64_t id ) const
+{
+    return View<P>( id );
+}
+
+
+
+template<typename K, typename V>
+template<typename P>
+P const& DiskRangeMap<K,V>::View( std::uint64_t id ) const
+{
+    constexpr bool        isLeaf   { std::is_same_v<P, LeafPage> };
+    constexpr std::size_t capacity { isLeaf ? LeafCapacity : InnerCapacity };
+
+    if( id < 2 || id >= mPageCount )
+    {
+        throw std::runtime_error( "DiskRangeMap: the file is corrupt, a page refers to a page outside of it" );
+    }
+
+    // the bytes of a frame provide storage for the page object
+    P const& page { *std::launder( reinterpret_cast<P const*>( mPool.read( id ).data() ) ) };
+
+    if( (page.header.isLeaf != 0) != isLeaf || page.header.count > capacity )
+    {
+        throw std::runtime_error( "DiskRangeMap: the file is corrupt, a page has an invalid header" );
+    }
+
+    return page;
+}
+
+
+
+template<typename K, typename V>
+bool DiskRangeMap<K,V>::IsLeaf( std::uint64_t id ) const
+{
+    PageHeader header;
+    std::memcpy( &header, mPool.read( id ).data(), sizeof(header) );
+
+    return header.isLeaf != 0;
+}
+
+
+
+template<typename K, typename V>
+template<typename P>
+std::uint64_t DiskRangeMap<K,V>::Store( std::uint64_t id, P const& page )
+{
+    std::uint64_t target { id };
+
+    // pages of the committed version are copied on write
+    if( id == NoPage || !IsFresh( id ) )
+    {
+        target = AllocatePage();
+        if( id != NoPage )
+        {
+            ReleasePage( id );
+        }
+    }
+
+    std::memcpy( mPool.create( target ).data(), static_cast<void const*>(&page), sizeof(P) );
+
+    return target;
+}
+
+
+
+template<typename K, typename V>
+std::uint64_t DiskRangeMap<K,V>::AllocatePage()
+{
+    std::uint64_t id;
+
+    if( !mFree.empty() )
+    {
+        id = mFree.back();
+        mFree.pop_back();
+    }
+    else
+    {
+        id = mPageCount++;
+        mIsFresh.resize( mPageCount, false );
+    }
+
+    mIsFresh[id] = true;
+    mFreshPages.push_back( id );
+
+    return id;
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::ReleasePage( std::uint64_t id )
+{
+    if( IsFresh( id ) )
+    {
+        // never committed, so it can be reused right away
+        mIsFresh[id] = false; // its entry in 'mFreshPages' is left, as clearing it again is harmless
+        mPool.drop( id );
+        mFree.push_back( id );
+    }
+    else
+    {
+        mPendingFree.push_back( id );
+    }
+}
+
+
+
+template<typename K, typename V>
+bool DiskRangeMap<K,V>::IsFresh( std::uint64_t id ) const
+{
+    return id < mIsFresh.size() && mIsFresh[id];
+}
+
+
+
+template<typename K, typename V>
+std::size_t DiskRangeMap<K,V>::ChildIndex( InnerPage const& inner, K const& key )
+{
+    auto const first = inner.keys.begin() + 1;
+    auto const last  = inner.keys.begin() + inner.header.count;
+
+    return std::size_t( std::upper_bound( first, last, key ) - first );
+}
+
+
+
+template<typename K, typename V>
+std::optional<std::pair<K,V>> DiskRangeMap<K,V>::FindLast( std::uint64_t id, K const& key, bool inclusive ) const
+{
+    if( id == NoPage )
+    {
+        return std::nullopt;
+    }
+
+    if( IsLeaf( id ) )
+    {
+        LeafPage const& leaf { View<LeafPage>( id ) };
+
+        auto const first = leaf.keys.begin();
+        auto const last  = leaf.keys.begin() + leaf.header.count;
+        auto const it    = inclusive ? std::upper_bound( first, last, key ) : std::lower_bound( first, last, key );
+
+        if( it == first )
+        {
+            return std::nullopt;
+        }
+
+        const std::size_t index { std::size_t( it - first ) - 1 };
+        return std::pair<K,V>{ leaf.keys[index], leaf.values[index] };
+    }
+
+    // the boundary is in the child holding 'key', unless all keys there are not less than it
+    for( std::size_t index{ ChildIndex( View<InnerPage>( id ), key ) + 1 }; index-- > 0; )
+    {
+        if( auto boundary = FindLast( View<InnerPage>( id ).children[index], key, inclusive ) )
+        {
+            return boundary;
+        }
+    }
+
+    return std::nullopt;
+}
+
+
+
+template<typename K, typename V>
+typename DiskRangeMap<K,V>::InsertResult DiskRangeMap<K,V>::Insert( std::uint64_t id, K const& key, V const& value )
+{
+    if( IsLeaf( id ) )
+    {
+        // a page of the uncommitted version with room left is changed in place
+        if( IsFresh( id ) && View<LeafPage>( id ).header.count < LeafCapacity )
+        {
+            auto& page = *std::launder( reinterpret_cast<LeafPage*>( mPool.write( id ).data() ) );
+
+            const std::size_t count { page.header.count };
+            const std::size_t pos   { std::size_t( std::lower_bound( page.keys.begin(), page.keys.begin() + count, key ) - page.keys.begin() ) };
+
+            if( pos == count || key < page.keys[pos] )
+            {
+                std::copy_backward( page.keys.begin()   + pos, page.keys.begin()   + count, page.keys.begin()   + count + 1 );
+                std::copy_backward( page.values.begin() + pos, page.values.begin() + count, page.values.begin() + count + 1 );
+                page.keys[pos] = key;
+                ++page.header.count;
+                ++mSize;
+            }
+            page.values[pos] = value;
+
+            return { id, std::nullopt };
+        }
+
+        LeafPage leaf { Load<LeafPage>( id ) };
+
+        std::size_t count { leaf.header.count };
+        std::size_t pos   { std::size_t( std::lower_bound( leaf.keys.begin(), leaf.keys.begin() + count, key ) - leaf.keys.begin() ) };
+
+        if( pos < count && !(key < leaf.keys[pos]) )
+        {
+            leaf.values[pos] = value;
+            return { Store( id, leaf ), std::nullopt };
+        }
+
+        // move the upper half to a new right sibling if full
+        LeafPage* target { &leaf };
+        LeafPage  right  {};
+        if( count == LeafCapacity )
+        {
+            // appending keys in order leaves full pages behind
+            const std::size_t half { pos == count ? count : count / 2 };
+            std::copy( leaf.keys.begin()   + half, leaf.keys.begin()   + count, right.keys.begin()   );
+            std::copy( leaf.values.begin() + half, leaf.values.begin() + count, right.values.begin() );
+            right.header     = { 1, std::uint32_t( count - half ) };
+            leaf.header.count = std::uint32_t( half );
+
+            if( pos >= half )
+            {
+                target = &right;
+                pos   -= half;
+            }
+            count = target->header.count;
+        }
+
+        std::copy_backward( target->keys.begin()   + pos, target->keys.begin()   + count, target->keys.begin()   + count + 1 );
+        std::copy_backward( target->values.begin() + pos, target->values.begin() + count, target->values.begin() + count + 1 );
+        target->keys[pos]   = key;
+        target->values[pos] = value;
+        ++target->header.count;
+        ++mSize;
+
+        InsertResult result { Store( id, leaf ), std::nullopt };
+        if( right.header.count > 0 )
+        {
+            result.split = std::pair<K, std::uint64_t>{ right.keys[0], Store( NoPage, right ) };
+        }
+        return result;
+    }
+
+    std::size_t         pos     { ChildIndex( View<InnerPage>( id ), key ) };
+    const std::uint64_t childId { View<InnerPage>( id ).children[pos] };
+    InsertResult        child   { Insert( childId, key, value ) };
+
+    // a child changed in place needs no change here
+    if( child.page == childId && !child.split )
+    {
+        return { id, std::nullopt };
+    }
+
+    InnerPage inner { Load<InnerPage>( id ) };
+    inner.children[pos] = child.page;
+
+    if( !child.split )
+    {
+        return { Store( id, inner ), std::nullopt };
+    }
+
+    // add the new sibling of the child after it, moving the upper half to a new right sibling if full
+    ++pos;
+    InnerPage* target { &inner };
+    InnerPage  right  {};
+    std::size_t count { inner.header.count };
+    if( count == InnerCapacity )
+    {
+        const std::size_t half { pos == count ? count : count / 2 };
+        std::copy( inner.keys.begin()     + half, inner.keys.begin()     + count, right.keys.begin()     );
+        std::copy( inner.children.begin() + half, inner.children.begin() + count, right.children.begin() );
+        right.header      = { 0, std::uint32_t( count - half ) };
+        inner.header.count = std::uint32_t( half );
+
+        if( pos >= half )
+        {
+            target = &right;
+            pos   -= half;
+        }
+        count = target->header.count;
+    }
+
+    std::copy_backward( target->keys.begin()     + pos, target->keys.begin()     + count, target->keys.begin()     + count + 1 );
+    std::copy_backward( target->children.begin() + pos, target->children.begin() + count, target->children.begin() + count + 1 );
+    target->keys[pos]     = child.split->first;
+    target->children[pos] = child.split->second;
+    ++target->header.count;
+
+    InsertResult result { Store( id, inner ), std::nullopt };
+    if( right.header.count > 0 )
+    {
+        result.split = std::pair<K, std::uint64_t>{ right.keys[0], Store( NoPage, right ) };
+    }
+    return result;
+}
+
+
+
+template<typename K, typename V>
+std::optional<std::uint64_t> DiskRangeMap<K,V>::EraseRange( std::uint64_t id, K const& lo, K const& hi, bool inclusive )
+{
+    if( IsLeaf( id ) )
+    {
+        LeafPage const& view { View<LeafPage>( id ) };
+
+        auto const viewBegin = view.keys.begin();
+        auto const viewEnd   = view.keys.begin() + view.header.count;
+        auto const viewFirst = std::lower_bound( viewBegin, viewEnd, lo );
+        auto const viewLast  = inclusive ? std::upper_bound( viewFirst, viewEnd, hi ) : std::lower_bound( viewFirst, viewEnd, hi );
+
+        if( viewFirst == viewLast )
+        {
+            return id;
+        }
+
+        LeafPage leaf { Load<LeafPage>( id ) };
+
+        auto const begin = leaf.keys.begin();
+        auto const end   = leaf.keys.begin() + leaf.header.count;
+        auto const first = std::lower_bound( begin, end, lo );
+        auto const last  = inclusive ? std::upper_bound( first, end, hi ) : std::lower_bound( first, end, hi );
+
+        if( first == last )
+        {
+            return id;
+        }
+
+        const auto firstPos { first - begin };
+        const auto lastPos  { last  - begin };
+
+        std::copy( leaf.keys.begin()   + lastPos, end,                                              leaf.keys.begin()   + firstPos );
+        std::copy( leaf.values.begin() + lastPos, leaf.values.begin() + leaf.header.count,          leaf.values.begin() + firstPos );
+        leaf.header.count -= std::uint32_t( lastPos - firstPos );
+        mSize             -= std::size_t( lastPos - firstPos );
+
+        if( leaf.header.count == 0 )
+        {
+            ReleasePage( id );
+            return std::nullopt;
+        }
+
+        return Store( id, leaf );
+    }
+
+    const std::size_t   first      { ChildIndex( View<InnerPage>( id ), lo ) };
+    const std::size_t   last       { ChildIndex( View<InnerPage>( id ), hi ) };
+    const std::uint64_t firstChild { View<InnerPage>( id ).children[first] };
+    const std::size_t   sizeBefore { mSize };
+
+    const auto firstResult = EraseRange( firstChild, lo, hi, inclusive );
+
+    // nothing was removed, or only from a child changed in place
+    if( first == last && firstResult == firstChild && mSize == sizeBefore )
+    {
+        return id;
+    }
+
+    const InnerPage inner { Load<InnerPage>( id ) };
+
+    InnerPage updated {};
+    updated.header = { 0, 0 };
+
+    auto append = [&updated]( K const& key, std::uint64_t child )
+    {
+        updated.keys    [updated.header.count] = key;
+        updated.children[updated.header.count] = child;
+        ++updated.header.count;
+    };
+
+    for( std::size_t index{0}; index < first; ++index )
+    {
+        append( inner.keys[index], inner.children[index] );
+    }
+
+    if( firstResult )
+    {
+        append( inner.keys[first], *firstResult );
+    }
+
+    const std::size_t seam { updated.header.count };
+
+    // the children between the first and the last one lie completely inside the range
+    for( std::size_t index{first + 1}; index < last; ++index )
+    {
+        mSize -= ReleaseSubtree( inner.children[index] );
+    }
+
+    if( last > first )
+    {
+        if( auto child = EraseRange( inner.children[last], lo, hi, inclusive ) )
+        {
+            append( inner.keys[last], *child );
+        }
+    }
+
+    for( std::size_t index{last + 1}; index < inner.header.count; ++index )
+    {
+        append( inner.keys[index], inner.children[index] );
+    }
+
+    if( mSize == sizeBefore )
+    {
+        return id;
+    }
+
+    if( updated.header.count == 0 )
+    {
+        ReleasePage( id );
+        return std::nullopt;
+    }
+
+    // merge the children left partly empty on both sides of the removed range with their neighbors
+    if( seam > 0 && seam < updated.header.count )
+    {
+        MergeChildren( updated, seam - 1 );
+    }
+    if( seam > 1 && seam - 1 < updated.header.count )
+    {
+        MergeChildren( updated, seam - 2 );
+    }
+
+    return Store( id, updated );
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::MergeChildren( InnerPage& parent, std::size_t index )
+{
+    if( index + 1 >= parent.header.count )
+    {
+        return;
+    }
+
+    const bool isMerged { IsLeaf( parent.children[index] ) ? MergePages<LeafPage,  LeafCapacity,  &LeafPage::values   >( parent, index )
+                                        : MergePages<InnerPage, InnerCapacity, &InnerPage::children>( parent, index ) };
+
+    if( isMerged )
+    {
+        const auto count { std::ptrdiff_t( parent.header.count ) };
+        const auto next  { std::ptrdiff_t( index + 1 ) };
+        std::copy( parent.keys.begin()     + next + 1, parent.keys.begin()     + count, parent.keys.begin()     + next );
+        std::copy( parent.children.begin() + next + 1, parent.children.begin() + count, parent.children.begin() + next );
+        --parent.header.count;
+    }
+}
+
+
+
+template<typename K, typename V>
+template<typename P, std::size_t Capacity, auto Entries>
+bool DiskRangeMap<K,V>::MergePages( InnerPage& parent, std::size_t index )
+{
+    const std::uint64_t leftId  { parent.children[index] };
+    const std::uint64_t rightId { parent.children[index + 1] };
+
+    P left  { Load<P>( leftId ) };
+    P right { Load<P>( rightId ) };
+
+    const std::size_t leftCount  { left.header.count };
+    const std::size_t rightCount { right.header.count };
+
+    if( leftCount + rightCount > Capacity || (2 * leftCount >= Capacity && 2 * rightCount >= Capacity) )
+    {
+        return false;
+    }
+
+    // the first key of an inner page is only known by its parent
+    if constexpr( std::is_same_v<P, InnerPage> )
+    {
+        right.keys[0] = parent.keys[index + 1];
+    }
+
+    const auto at { std::ptrdiff_t( leftCount ) };
+    std::copy( right.keys.begin(),        right.keys.begin()        + std::ptrdiff_t( rightCount ), left.keys.begin()        + at );
+    std::copy( (right.*Entries).begin(), (right.*Entries).begin() + std::ptrdiff_t( rightCount ), (left.*Entries).begin() + at );
+    left.header.count = std::uint32_t( leftCount + rightCount );
+
+    parent.children[index] = Store( leftId, left );
+    ReleasePage( rightId );
+
+    return true;
+}
+
+
+
+template<typename K, typename V>
+std::size_t DiskRangeMap<K,V>::ReleaseSubtree( std::uint64_t id )
+{
+    std::size_t count { 0 };
+
+    if( IsLeaf( id ) )
+    {
+        count = View<LeafPage>( id ).header.count;
+    }
+    else
+    {
+        const InnerPage inner { Load<InnerPage>( id ) };
+        for( std::size_t index{0}; index < inner.header.count; ++index )
+        {
+            count += ReleaseSubtree( inner.children[index] );
+        }
+    }
+
+    ReleasePage( id );
+    return count;
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::InsertAtRoot( K const& key, V const& value )
+{
+    if( mRoot == NoPage )
+    {
+        LeafPage leaf {};
+        leaf.header    = { 1, 1 };
+        leaf.keys[0]   = key;
+        leaf.values[0] = value;
+
+        mRoot   = Store( NoPage, leaf );
+        mHeight = 1;
+        ++mSize;
+        return;
+    }
+
+    const InsertResult result { Insert( mRoot, key, value ) };
+    mRoot = result.page;
+
+    // grow the tree by one level if the root was split
+    if( result.split )
+    {
+        InnerPage root {};
+        root.header      = { 0, 2 };
+        root.keys[1]     = result.split->first;
+        root.children[0] = mRoot;
+        root.children[1] = result.split->second;
+
+        mRoot = Store( NoPage, root );
+        ++mHeight;
+    }
+}
+
+
+
+template<typename K, typename V>
+void DiskRangeMap<K,V>::EraseAtRoot( K const& lo, K const& hi, bool inclusive )
+{
+    if( mRoot == NoPage )
+    {
+        return;
+    }
+
+    const auto root = EraseRange( mRoot, lo, hi, inclusive );
+    if( !root )
+    {
+        mRoot   = NoPage;
+        mHeight = 0;
+        return;
+    }
+    mRoot = *root;
+
+    // shrink the tree while the root has a single child
+    while( mHeight > 1 )
+    {
+        InnerPage const& inner { View<InnerPage>( mRoot ) };
+        if( inner.header.count > 1 )
+        {
+            break;
+        }
+
+        const std::uint64_t child { inner.children[0] };
+        ReleasePage( mRoot );
+        mRoot = child;
+        --mHeight;
+    }
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void DiskRangeMap<K,V>::ForEach( std::uint64_t id, F& fn ) const
+{
+    if( IsLeaf( id ) )
+    {
+        const LeafPage leaf { Load<LeafPage>( id ) };
+        for( std::size_t index{0}; index < leaf.header.count; ++index )
+        {
+            fn( leaf.keys[index], leaf.values[index] );
+        }
+        return;
+    }
+
+    const InnerPage inner { Load<InnerPage>( id ) };
+    for( std::size_t index{0}; index < inner.header.count; ++index )
+    {
+        ForEach( inner.children[index], fn );
+    }
+}
+
+
+
+template<typename K, typename V>
+std::uint64_t DiskRangeMap<K,V>::Checksum( Superblock const& block )
+{
+    // FNV-1a over the bytes after the checksum
+    auto const* bytes { reinterpret_cast<unsigned char const*>( &block ) };
+
+    std::uint64_t hash { 0xcbf29ce484222325 };
+    for( std::size_t pos{ sizeof(block.checksum) }; pos < sizeof(block); ++pos )
+    {
+        hash = (hash ^ bytes[pos]) * 0x100000001b3;
+    }
+
+    return hash;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[ in a sorted vector of range
+ *        boundaries, laid out like 'RangeMap::data()'. The vector stays canonical if it was
+ *        canonical before. Used by the containers that store their ranges in flat arrays.
+ *        The runtime is O(log N) plus moving the elements after the range.
+ *
+ * @param entries      Range boundaries sorted by key, each range lasts until the next boundary.
+ * @param valueBefore  The value of the range before the first element of 'entries'.
+ * @param keyBegin     The start of the range, must be less than 'keyEnd'.
+ * @param keyEnd       The end of the range, which is excluded from the range.
+ * @param keyVal       The value to associate to the range ['keyBegin', 'keyEnd'[
+ */
+template<typename K, typename V>
+constexpr void FlatRangeAssign( std::vector<std::pair<K,V>>& entries, V const& valueBefore, K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // Find the elements replaced by the new range, which are the ones with keys in ['keyBegin', 'keyEnd']
+    auto keyBeginPos = std::lower_bound( entries.begin(), entries.end(), keyBegin,
+                                         []( std::pair<K,V> const& entry, K const& key ){ return entry.first < key; } );
+    auto keyEndPos   = std::upper_bound( keyBeginPos, entries.end(), keyEnd,
+                                         []( K const& key, std::pair<K,V> const& entry ){ return key < entry.first; } );
+
+    V const& valueBeforeBegin { keyBeginPos == entries.begin() ? valueBefore : std::prev(keyBeginPos)->second };
+    V        valueAtEnd       { keyEndPos   == entries.begin() ? valueBefore : std::prev(keyEndPos)->second   };
+
+    const bool insertKeyBegin { !(valueBeforeBegin == keyVal) }; // otherwise the previous range is extended
+    const bool insertKeyEnd   { !(valueAtEnd       == keyVal) }; // otherwise the new range is extended by the range after it
+
+    // Reuse the replaced elements for the new boundaries, and only insert or erase the difference
+    std::size_t replaced { std::size_t( keyEndPos - keyBeginPos ) };
+    auto        writePos { keyBeginPos };
+
+    auto write = [&]( std::pair<K,V>&& entry )
+    {
+        if( replaced > 0 )
+        {
+            *writePos = std::move(entry);
+            --replaced;
+        }
+        else
+        {
+            writePos = entries.insert( writePos, std::move(entry) );
+        }
+        ++writePos;
+    };
+
+    if( insertKeyBegin )
+    {
+        write( { keyBegin, keyVal } );
+    }
+
+    if( insertKeyEnd )
+    {
+        write( { keyEnd, std::move(valueAtEnd) } );
+    }
+
+    entries.erase( writePos, writePos + std::ptrdiff_t(replaced) );
+}
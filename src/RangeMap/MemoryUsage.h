@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief The memory used by a range map container, as reported by its 'memory_usage()'.
+ *        Bytes are counted from the sizes of the allocated objects, the bookkeeping of the
+ *        memory allocator itself is not included.
+ */
+struct RangeMapMemoryUsage
+{
+    std::size_t boundaries { 0 }; // Number of stored range boundaries
+    std::size_t nodeBytes  { 0 }; // Bytes of the container structure, like tree nodes, pointers and unused capacity
+    std::size_t keyBytes   { 0 }; // Bytes of the stored keys, including the heap memory they own
+    std::size_t valueBytes { 0 }; // Bytes of the stored values, including the heap memory they own
+    std::size_t extraBytes { 0 }; // Bytes of optional structures, like a change log or a value index
+
+
+    std::size_t total() const
+    {
+        return nodeBytes + keyBytes + valueBytes + extraBytes;
+    }
+
+
+    RangeMapMemoryUsage& operator+=( RangeMapMemoryUsage const& other )
+    {
+        boundaries += other.boundaries;
+        nodeBytes  += other.nodeBytes;
+        keyBytes   += other.keyBytes;
+        valueBytes += other.valueBytes;
+        extraBytes += other.extraBytes;
+        return *this;
+    }
+};
+
+
+
+/**
+ * @brief Customization point for the heap memory owned by a key or value, which is added to
+ *        the bytes of the object itself. Types that own heap memory should specialize it,
+ *        all other types own none.
+ */
+template<typename T>
+struct RangeMapHeapBytes
+{
+    std::size_t operator()( T const& ) const
+    {
+        return 0;
+    }
+};
+
+
+
+template<typename C, typename Traits, typename Alloc>
+struct RangeMapHeapBytes<std::basic_string<C, Traits, Alloc>>
+{
+    std::size_t operator()( std::basic_string<C, Traits, Alloc> const& str ) const
+    {
+        // short strings are stored inside the object itself
+        auto const* object { reinterpret_cast<char const*>( &str ) };
+        auto const* data   { reinterpret_cast<char const*>( str.data() ) };
+
+        const bool isInline { !std::less<char const*>{}( data, object ) &&
+                               std::less<char const*>{}( data, object + sizeof(str) ) };
+
+        return isInline ? 0 : (str.capacity() + 1) * sizeof(C);
+    }
+};
+
+
+
+template<typename T, typename Alloc>
+struct RangeMapHeapBytes<std::vector<T, Alloc>>
+{
+    std::size_t operator()( std::vector<T, Alloc> const& vec ) const
+    {
+        std::size_t bytes { vec.capacity() * sizeof(T) };
+
+        for( T const& element : vec )
+        {
+            bytes += RangeMapHeapBytes<T>{}( element );
+        }
+
+        return bytes;
+    }
+};
+
+
+
+template<typename T>
+struct RangeMapHeapBytes<std::optional<T>>
+{
+    std::size_t operator()( std::optional<T> const& opt ) const
+    {
+        return opt ? RangeMapHeapBytes<T>{}( *opt ) : 0;
+    }
+};
+
+
+
+/**
+ * @brief Returns the bytes of 'object' plus the heap memory it owns.
+ */
+template<typename T>
+std::size_t ObjectBytes( T const& object )
+{
+    return sizeof(T) + RangeMapHeapBytes<T>{}( object );
+}
+
+
+
+/**
+ * @brief Estimated bytes of a node of a red-black tree, as used by 'std::map', that holds an
+ *        element of type 'T': a color and three pointers, followed by the element.
+ */
+template<typename T>
+constexpr std::size_t TreeNodeBytes()
+{
+    return 4 * sizeof(void*) + sizeof(T);
+}
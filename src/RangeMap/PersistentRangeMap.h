@@ -0,0 +1,1152 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <unordered_set>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A persistent (copy-on-write) variant of RangeMap. The ranges are stored in a
+ *        balanced binary tree (treap) whose nodes are immutable and shared between versions,
+ *        so 'snapshot()' is O(1) and 'assign()' only copies the O(log N) nodes on the paths
+ *        it changes. Nodes of old versions are freed when the last snapshot using them is
+ *        dropped, except for the ranges dropped by 'truncate_before()', which are freed a few
+ *        nodes at a time by later calls.
+ *
+ *        A snapshot can be read from other threads while the map it was taken from keeps
+ *        being assigned to, but a single object must not be assigned to and read concurrently.
+ *
+ * @tparam K  The key type, must be copyable, assignable and less-than comparable via operator<
+ * @tparam V  The value type, must be copyable, assignable and equality-comparable via operator==
+ */
+template<typename K, typename V>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V>
+class PersistentRangeMap
+{
+  public:
+    /**
+     * @brief Construct a new Persistent Range Map object where the whole range of K
+     *        is associated with value 'defaultVal'.
+     *
+     * @param defaultVal The value which will be returned when looking up
+     *                   K values that fall outside ranges.
+     */
+    PersistentRangeMap( V const& defaultVal )
+    : mDefaultVal { defaultVal }
+    {}
+
+
+
+    /**
+     * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[, overwriting any previous
+     *        values which overlap with this range. Ranges where 'keyEnd' is not greater
+     *        than 'keyBegin' are ignored. Snapshots taken earlier are not affected.
+     *        The runtime for this call is expected O(log N) plus freeing the overwritten
+     *        ranges that are not shared with a snapshot.
+     *
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range. Note that the range excludes 'keyEnd'.
+     * @param keyVal    The value to associate to the range ['keyBegin', 'keyEnd'[
+     */
+    void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key' in expected O(log N)
+     *
+     * @param key  The key to lookup
+     * @return     The value associated with 'key'
+     */
+    V const& operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Returns a point-in-time copy of the container in O(1). The
+     *        snapshot shares all nodes with the container.
+     */
+    PersistentRangeMap snapshot() const;
+
+
+
+    /**
+     * @brief Returns the number of stored range boundaries.
+     */
+    std::size_t size() const;
+
+
+
+    /**
+     * @brief Calls 'fn(key, value)' for every stored range boundary, in key order.
+     */
+    template<typename F>
+    void for_each( F&& fn ) const;
+
+
+
+    /**
+     * @brief Returns the stored range boundaries as a 'std::map', in the layout used
+     *        by 'RangeMap::data()'. The runtime is O(N).
+     */
+    std::map<K,V> to_map() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the nodes of the tree. Nodes shared with snapshots
+     *        are counted by every container that shares them. The runtime is O(N).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+    /**
+     * @brief Same as 'memory_usage()', but skips the nodes in 'counted' and adds the others to
+     *        it, so that nodes shared by several containers are counted once in total. The
+     *        runtime is O(number of nodes not in 'counted').
+     */
+    RangeMapMemoryUsage memory_usage( std::unordered_set<void const*>& counted ) const;
+
+
+
+    /**
+     * @brief Drops all ranges before 'watermark': keys before it take the default value, and a
+     *        range reaching over it is cut at it. The runtime for this call is expected O(log N)
+     *        however many ranges are dropped, since their nodes are not freed right away.
+     *        Instead, 'assign()' and 'truncate_before()' free up to 'ReclaimBudget' of them per
+     *        call, and 'reclaim()' frees them on demand.
+     */
+    void truncate_before( K const& watermark );
+
+
+
+    /**
+     * @brief Keeps only the last 'window' keys: after every 'assign()', the ranges before the
+     *        last stored boundary minus 'window' are dropped with 'truncate_before()'. Meant for
+     *        keys like timestamps, whose values are not less than 'window'.
+     */
+    void set_retention( K const& window )
+        requires is_subtractable<K>;
+
+
+
+    /**
+     * @brief Frees up to 'maxNodes' of the nodes dropped by 'truncate_before()'. Nodes still
+     *        shared with a snapshot are left to the snapshot.
+     *
+     * @return  true if no dropped nodes are left to free.
+     */
+    bool reclaim( std::size_t maxNodes );
+
+
+
+    /**
+     * @brief Splits the container at 'key' in expected O(log N). The first container returned
+     *        holds the ranges of the keys before 'key', and the second one the ranges of the keys
+     *        from 'key' on; every other key holds the default value. Both share their nodes with
+     *        this container, which is not changed.
+     */
+    std::pair<PersistentRangeMap, PersistentRangeMap> split( K const& key ) const;
+
+
+
+    /**
+     * @brief Joins two containers in expected O(log N), so that the result holds the ranges of
+     *        both. All ranges of 'left' must end at or before the start of the first range of
+     *        'right', and both must have the same default value. When the last range of 'left'
+     *        ends where the first range of 'right' begins and both hold the same value, they are
+     *        merged, so joining the two halves of a 'split()' restores the original container.
+     */
+    static PersistentRangeMap join( PersistentRangeMap const& left, PersistentRangeMap const& right );
+
+
+
+    /**
+     * @brief Returns a hash of the stored ranges and the default value in O(1). The hash only
+     *        depends on the ranges, not on the order of the assignments that produced them or
+     *        the shape of the tree, so replicas can compare it to check if they are in sync.
+     */
+    std::uint64_t content_hash() const
+        requires is_hashable<K> && is_hashable<V>;
+
+
+
+    /**
+     * @brief Returns true if both containers have the same default value, number of boundaries
+     *        and 'content_hash()', in O(1). Equal containers always have the same content, but
+     *        two different containers are reported as equal when their hashes collide. With 64
+     *        bit hashes that is unlikely for unrelated contents, but 'std::hash' is not collision
+     *        resistant, so keys and values chosen by an attacker can collide on purpose. Use
+     *        'operator==' when a false positive is not acceptable.
+     */
+    bool same_content( PersistentRangeMap const& other ) const
+        requires is_hashable<K> && is_hashable<V>;
+
+
+
+    /**
+     * @brief Returns the spans of keys ['keyBegin', 'keyEnd'[ where this container and 'other'
+     *        associate different values, in key order. Both containers must have the same
+     *        default value.
+     *
+     *        Every subtree keeps the sum of the hashes of its boundaries, so the hash of the
+     *        boundaries in any key range is found in O(log N). Key ranges with equal hashes
+     *        on both sides are skipped, and the others are halved until they hold only a few
+     *        boundaries, so the runtime is O(d log^2 N) for d differing spans. Like any hash
+     *        comparison, differences whose hashes collide are missed, which is unlikely with
+     *        64 bit hashes.
+     */
+    std::vector<std::pair<K,K>> diff( PersistentRangeMap const& other ) const
+        requires is_hashable<K> && is_hashable<V>;
+
+
+
+    /**
+     * @brief Returns true if both containers associate the same values to all keys. This is
+     *        O(1) when the containers share their tree, for example after a snapshot, or when
+     *        their hashes differ. Containers with equal ranges in trees that are not shared,
+     *        for example because they were built by different assignments, are compared
+     *        boundary by boundary in O(N). Use 'same_content()' to compare them in O(1).
+     */
+    friend bool operator==( PersistentRangeMap const& lhs, PersistentRangeMap const& rhs )
+    {
+        return lhs.mDefaultVal == rhs.mDefaultVal && SameRanges( lhs.mRoot, rhs.mRoot );
+    }
+
+
+
+  private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node
+    {
+        K             key;
+        V             value;
+        std::uint64_t priority; // Heap order of the treap, a parent has a higher priority than its children
+        std::size_t   count;    // Number of nodes in the subtree
+        std::uint64_t hash;     // Sum of the hashes of the boundaries in the subtree, 0 unless K and V are hashable
+        NodePtr       left;
+        NodePtr       right;
+    };
+
+
+    /**
+     * @brief Creates a node with the subtree count computed from 'left' and 'right'.
+     */
+    static NodePtr MakeNode( K const& key, V const& value, std::uint64_t priority, NodePtr left, NodePtr right );
+
+
+    /**
+     * @brief Creates a copy of 'node' with new children.
+     */
+    static NodePtr CopyNode( Node const& node, NodePtr left, NodePtr right );
+
+
+    /**
+     * @brief Creates a single node with a random priority.
+     */
+    static NodePtr MakeLeaf( K const& key, V const& value );
+
+
+    /**
+     * @brief Splits 'tree' into the nodes with keys less than 'key' and the nodes with
+     *        keys greater than or equal to 'key'. Only the nodes on the search path
+     *        for 'key' are copied.
+     */
+    static std::pair<NodePtr, NodePtr> Split( NodePtr const& tree, K const& key );
+
+
+    /**
+     * @brief Joins two trees, where all keys in 'lhs' are less than all keys in 'rhs'.
+     */
+    static NodePtr Join( NodePtr const& lhs, NodePtr const& rhs );
+
+
+    /**
+     * @brief Returns 'tree' without its first node.
+     */
+    static NodePtr RemoveFirst( NodePtr const& tree );
+
+
+    /**
+     * @brief Returns 'tree' without its last node.
+     */
+    static NodePtr RemoveLast( NodePtr const& tree );
+
+
+    static Node const* First( NodePtr const& tree );
+    static Node const* Last ( NodePtr const& tree );
+
+
+    template<typename F>
+    static void ForEach( Node const* node, F& fn );
+
+
+    template<typename F>
+    static void ForEachNode( Node const* node, F& fn );
+
+
+    /**
+     * @brief Adds the nodes of 'node' that are not in 'counted' to 'usage'. A counted node is
+     *        skipped with its subtrees, since nodes are immutable and share whole subtrees.
+     */
+    static void CountNodes( Node const* node, std::unordered_set<void const*>& counted, RangeMapMemoryUsage& usage );
+
+
+    /**
+     * @brief Returns true if both trees hold the same range boundaries.
+     */
+    static bool SameRanges( NodePtr const& lhs, NodePtr const& rhs );
+
+
+    static constexpr bool IsHashed { is_hashable<K> && is_hashable<V> };
+
+
+    /**
+     * @brief Returns the hash of boundary 'key' holding 'value'. Subtree hashes are sums of
+     *        these, so they do not depend on the shape of the tree.
+     */
+    static std::uint64_t EntryHash( K const& key, V const& value );
+
+
+    struct RangeSummary
+    {
+        std::size_t   count { 0 }; // Number of boundaries
+        std::uint64_t hash  { 0 }; // Sum of their hashes
+    };
+
+
+    /**
+     * @brief Summarizes the boundaries of 'tree' with keys less than 'key', or all of them
+     *        if 'key' is null.
+     */
+    static RangeSummary SummaryBefore( NodePtr const& tree, K const* key );
+
+
+    /**
+     * @brief Summarizes the boundaries of 'tree' in ['keyBegin', 'keyEnd'[, where a null key
+     *        is unbounded.
+     */
+    static RangeSummary SummaryOf( NodePtr const& tree, K const* keyBegin, K const* keyEnd );
+
+
+    /**
+     * @brief Returns the key of the boundary with 'rank' boundaries before it.
+     */
+    static K const& KeyAtRank( NodePtr const& tree, std::size_t rank );
+
+
+    /**
+     * @brief Appends the boundaries of 'node' in ['keyBegin', 'keyEnd'[ to 'out', where a null
+     *        key is unbounded.
+     */
+    static void CollectBoundaries( Node const* node, K const* keyBegin, K const* keyEnd, std::vector<Node const*>& out );
+
+
+    /**
+     * @brief Appends the spans in ['keyBegin', 'keyEnd'[ where this container and 'other'
+     *        differ to 'out', see 'diff()'.
+     */
+    void DiffSpans( PersistentRangeMap const& other, K const* keyBegin, K const* keyEnd, std::vector<std::pair<K,K>>& out ) const;
+
+
+    /**
+     * @brief Same as 'DiffSpans()', by walking all boundaries in the key range.
+     */
+    void CompareSpans( PersistentRangeMap const& other, K const* keyBegin, K const* keyEnd, std::vector<std::pair<K,K>>& out ) const;
+
+
+    /**
+     * @brief Nodes waiting to be freed by 'reclaim()'. They belong to the container they were
+     *        dropped from, so copies of the container, like snapshots, start without any.
+     */
+    struct ReclaimList
+    {
+        ReclaimList() = default;
+        ReclaimList( ReclaimList const& ) {}
+        ReclaimList( ReclaimList&& ) = default;
+        ReclaimList& operator=( ReclaimList const& ) { return *this; }
+        ReclaimList& operator=( ReclaimList&& ) = default;
+
+        std::vector<NodePtr> nodes;
+    };
+
+    static constexpr std::size_t ReclaimBudget { 64 }; // Dropped nodes freed by each 'assign()' and 'truncate_before()'
+
+
+
+    // Member variables
+    V                mDefaultVal;   // Default value for values of 'K' that fall outside ranges
+    NodePtr          mRoot;         // Root of the treap storing the ranges, empty if there are no ranges
+    ReclaimList      mReclaim;      // Dropped subtrees that are freed incrementally
+    std::optional<K> mRetention;    // Number of keys to keep before the last boundary, if set
+};
+
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // ignore invalid range
+    if( !(keyBegin < keyEnd) )
+    {
+        return;
+    }
+
+    // Cut the tree into the part before, inside and after the new range:
+    //
+    //          keyBegin      keyEnd
+    //              |           |
+    //              ▼           ▼
+    // [  'a'  'b'   |  'c'  'd' |  'e'  's'  ]
+    //  \_________/   \_______/   \________/
+    //     lhs           mid          rhs
+    //
+    auto [lhs, rest] = Split( mRoot, keyBegin );
+    auto [mid, rhs]  = Split( rest,  keyEnd   );
+
+    Node const* lhsLast  { Last(lhs) };
+    Node const* midLast  { Last(mid) };
+    Node const* rhsFirst { First(rhs) };
+
+    V const& valueBeforeBegin { lhsLast ? lhsLast->value : mDefaultVal };
+    V const& valueAtEnd       { midLast ? midLast->value : valueBeforeBegin };
+
+    NodePtr seam;
+
+    // insert 'keyBegin', unless the previous range is extended
+    if( !(valueBeforeBegin == keyVal) )
+    {
+        seam = MakeLeaf( keyBegin, keyVal );
+    }
+
+    // insert 'keyEnd', continuing the range the new range was placed on top of
+    const bool isRangeStartingAtKeyEnd { rhsFirst && !(keyEnd < rhsFirst->key) };
+    if( isRangeStartingAtKeyEnd )
+    {
+        if( rhsFirst->value == keyVal )
+        {
+            rhs = RemoveFirst( rhs ); // new range is extended by the range after it
+        }
+    }
+    else if( !(valueAtEnd == keyVal) )
+    {
+        seam = Join( seam, MakeLeaf( keyEnd, valueAtEnd ) );
+    }
+
+    mRoot = Join( Join( lhs, seam ), rhs );
+
+    if constexpr( is_subtractable<K> )
+    {
+        Node const* last { Last(mRoot) };
+        if( mRetention && last && !(last->key < *mRetention) )
+        {
+            truncate_before( K( last->key - *mRetention ) );
+            return;
+        }
+    }
+
+    reclaim( ReclaimBudget );
+}
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::truncate_before( K const& watermark )
+{
+    auto [dropped, kept] = Split( mRoot, watermark );
+
+    Node const* droppedLast { Last(dropped) };
+    Node const* keptFirst   { First(kept) };
+
+    V const& valueAtWatermark { droppedLast ? droppedLast->value : mDefaultVal };
+
+    // the range reaching over 'watermark' now starts at it
+    const bool isRangeStartingAtWatermark { keptFirst && !(watermark < keptFirst->key) };
+    if( !isRangeStartingAtWatermark && !(valueAtWatermark == mDefaultVal) )
+    {
+        kept = Join( MakeLeaf( watermark, valueAtWatermark ), kept );
+    }
+    else if( isRangeStartingAtWatermark && keptFirst->value == mDefaultVal )
+    {
+        kept = RemoveFirst( kept );
+    }
+
+    if( dropped )
+    {
+        mReclaim.nodes.push_back( std::move(dropped) );
+    }
+
+    mRoot = std::move(kept);
+
+    reclaim( ReclaimBudget );
+}
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::set_retention( K const& window )
+    requires is_subtractable<K>
+{
+    mRetention = window;
+}
+
+
+
+template<typename K, typename V>
+bool PersistentRangeMap<K,V>::reclaim( std::size_t maxNodes )
+{
+    auto& pending = mReclaim.nodes;
+
+    for( std::size_t count{0}; count < maxNodes && !pending.empty(); ++count )
+    {
+        NodePtr node { std::move( pending.back() ) };
+        pending.pop_back();
+
+        // Hold on to the children, so that releasing a node only frees the node itself and not
+        // its whole subtree. Nodes shared with a snapshot are only released, not freed.
+        if( node.use_count() == 1 )
+        {
+            if( node->left )  { pending.push_back( node->left );  }
+            if( node->right ) { pending.push_back( node->right ); }
+        }
+    }
+
+    return pending.empty();
+}
+
+
+
+template<typename K, typename V>
+V const& PersistentRangeMap<K,V>::operator[]( K const& key ) const
+{
+    // find the last node with a key less than or equal to 'key'
+    Node const* found { nullptr };
+    Node const* node  { mRoot.get() };
+
+    while( node )
+    {
+        if( key < node->key )
+        {
+            node = node->left.get();
+        }
+        else
+        {
+            found = node;
+            node  = node->right.get();
+        }
+    }
+
+    return found ? found->value : mDefaultVal;
+}
+
+
+
+template<typename K, typename V>
+PersistentRangeMap<K,V> PersistentRangeMap<K,V>::snapshot() const
+{
+    return *this;
+}
+
+
+
+template<typename K, typename V>
+std::size_t PersistentRangeMap<K,V>::size() const
+{
+    return mRoot ? mRoot->count : 0;
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void PersistentRangeMap<K,V>::for_each( F&& fn ) const
+{
+    ForEach( mRoot.get(), fn );
+}
+
+
+
+template<typename K, typename V>
+std::map<K,V> PersistentRangeMap<K,V>::to_map() const
+{
+    std::map<K,V> out;
+
+    for_each( [&out]( K const& key, V const& value ){ out.emplace_hint( out.end(), key, value ); } );
+
+    return out;
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage PersistentRangeMap<K,V>::memory_usage() const
+{
+    // every node is allocated by 'std::make_shared', together with its reference counts
+    constexpr std::size_t controlBytes { 2 * sizeof(void*) };
+
+    RangeMapMemoryUsage usage;
+    usage.boundaries = size();
+    usage.nodeBytes  = size() * (controlBytes + sizeof(Node) - sizeof(K) - sizeof(V));
+
+    for_each( [&usage]( K const& key, V const& value )
+    {
+        usage.keyBytes   += ObjectBytes( key );
+        usage.valueBytes += ObjectBytes( value );
+    });
+
+    return usage;
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage PersistentRangeMap<K,V>::memory_usage( std::unordered_set<void const*>& counted ) const
+{
+    RangeMapMemoryUsage usage;
+    CountNodes( mRoot.get(), counted, usage );
+
+    return usage;
+}
+
+
+
+template<typename K, typename V>
+std::pair<PersistentRangeMap<K,V>, PersistentRangeMap<K,V>> PersistentRangeMap<K,V>::split( K const& key ) const
+{
+    auto [lhs, rhs] = Split( mRoot, key );
+
+    Node const* lhsLast  { Last(lhs) };
+    Node const* rhsFirst { First(rhs) };
+
+    V const& valueAtKey { lhsLast ? lhsLast->value : mDefaultVal }; // value of 'key', unless a range starts there
+
+    const bool isRangeStartingAtKey { rhsFirst && !(key < rhsFirst->key) };
+
+    // the left part ends with a range reaching up to 'key', which now ends there
+    if( !(valueAtKey == mDefaultVal) )
+    {
+        lhs = Join( lhs, MakeLeaf( key, mDefaultVal ) );
+    }
+
+    // the right part starts with the range reaching over 'key', or the one starting at it
+    if( !isRangeStartingAtKey && !(valueAtKey == mDefaultVal) )
+    {
+        rhs = Join( MakeLeaf( key, valueAtKey ), rhs );
+    }
+    else if( isRangeStartingAtKey && rhsFirst->value == mDefaultVal )
+    {
+        rhs = RemoveFirst( rhs );
+    }
+
+    std::pair<PersistentRangeMap, PersistentRangeMap> out { PersistentRangeMap { mDefaultVal }, PersistentRangeMap { mDefaultVal } };
+    out.first.mRoot  = std::move(lhs);
+    out.second.mRoot = std::move(rhs);
+
+    return out;
+}
+
+
+
+template<typename K, typename V>
+PersistentRangeMap<K,V> PersistentRangeMap<K,V>::join( PersistentRangeMap const& left, PersistentRangeMap const& right )
+{
+    assert( left.mDefaultVal == right.mDefaultVal && "containers have different default values" );
+
+    Node const* leftLast   { Last(left.mRoot) };
+    Node const* rightFirst { First(right.mRoot) };
+
+    assert( (!leftLast || !rightFirst || !(rightFirst->key < leftLast->key)) && "ranges of 'left' overlap with 'right'" );
+
+    NodePtr lhs { left.mRoot  };
+    NodePtr rhs { right.mRoot };
+
+    // the last boundary of 'left' ends its last range, drop it if the first range of 'right' starts there
+    const bool isSeam { leftLast && rightFirst && !(leftLast->key < rightFirst->key) };
+    if( isSeam )
+    {
+        lhs = RemoveLast( lhs );
+
+        Node const* beforeSeam { Last(lhs) };
+        if( (beforeSeam ? beforeSeam->value : left.mDefaultVal) == rightFirst->value )
+        {
+            rhs = RemoveFirst( rhs ); // the ranges on both sides of the seam merge
+        }
+    }
+
+    PersistentRangeMap out { left.mDefaultVal };
+    out.mRoot = Join( lhs, rhs );
+
+    return out;
+}
+
+
+
+template<typename K, typename V>
+std::uint64_t PersistentRangeMap<K,V>::content_hash() const
+    requires is_hashable<K> && is_hashable<V>
+{
+    return (mRoot ? mRoot->hash : 0) ^ (std::uint64_t( std::hash<V>{}( mDefaultVal ) ) * 0x9E3779B97F4A7C15ull);
+}
+
+
+
+template<typename K, typename V>
+bool PersistentRangeMap<K,V>::same_content( PersistentRangeMap const& other ) const
+    requires is_hashable<K> && is_hashable<V>
+{
+    return mDefaultVal == other.mDefaultVal && size() == other.size() && content_hash() == other.content_hash();
+}
+
+
+
+template<typename K, typename V>
+std::vector<std::pair<K,K>> PersistentRangeMap<K,V>::diff( PersistentRangeMap const& other ) const
+    requires is_hashable<K> && is_hashable<V>
+{
+    assert( mDefaultVal == other.mDefaultVal && "containers have different default values" );
+
+    std::vector<std::pair<K,K>> out;
+    DiffSpans( other, nullptr, nullptr, out );
+    return out;
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::NodePtr PersistentRangeMap<K,V>::MakeNode( K const& key, V const& value, std::uint64_t priority, NodePtr left, NodePtr right )
+{
+    const std::size_t count { 1 + (left ? left->count : 0) + (right ? right->count : 0) };
+
+    std::uint64_t hash { 0 };
+    if constexpr( IsHashed )
+    {
+        hash = EntryHash( key, value ) + (left ? left->hash : 0) + (right ? right->hash : 0);
+    }
+
+    return std::make_shared<const Node>( Node { key, value, priority, count, hash, std::move(left), std::move(right) } );
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::NodePtr PersistentRangeMap<K,V>::CopyNode( Node const& node, NodePtr left, NodePtr right )
+{
+    return MakeNode( node.key, node.value, node.priority, std::move(left), std::move(right) );
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::NodePtr PersistentRangeMap<K,V>::MakeLeaf( K const& key, V const& value )
+{
+    thread_local std::mt19937_64 generator { std::random_device{}() };
+
+    return MakeNode( key, value, generator(), nullptr, nullptr );
+}
+
+
+
+template<typename K, typename V>
+std::pair<typename PersistentRangeMap<K,V>::NodePtr, typename PersistentRangeMap<K,V>::NodePtr>
+PersistentRangeMap<K,V>::Split( NodePtr const& tree, K const& key )
+{
+    if( !tree )
+    {
+        return { nullptr, nullptr };
+    }
+
+    if( tree->key < key )
+    {
+        auto [lhs, rhs] = Split( tree->right, key );
+        return { CopyNode( *tree, tree->left, std::move(lhs) ), std::move(rhs) };
+    }
+    else
+    {
+        auto [lhs, rhs] = Split( tree->left, key );
+        return { std::move(lhs), CopyNode( *tree, std::move(rhs), tree->right ) };
+    }
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::NodePtr PersistentRangeMap<K,V>::Join( NodePtr const& lhs, NodePtr const& rhs )
+{
+    if( !lhs ) { return rhs; }
+    if( !rhs ) { return lhs; }
+
+    if( rhs->priority < lhs->priority )
+    {
+        return CopyNode( *lhs, lhs->left, Join( lhs->right, rhs ) );
+    }
+    else
+    {
+        return CopyNode( *rhs, Join( lhs, rhs->left ), rhs->right );
+    }
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::NodePtr PersistentRangeMap<K,V>::RemoveFirst( NodePtr const& tree )
+{
+    if( !tree->left )
+    {
+        return tree->right;
+    }
+
+    return CopyNode( *tree, RemoveFirst( tree->left ), tree->right );
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::NodePtr PersistentRangeMap<K,V>::RemoveLast( NodePtr const& tree )
+{
+    if( !tree->right )
+    {
+        return tree->left;
+    }
+
+    return CopyNode( *tree, tree->left, RemoveLast( tree->right ) );
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::Node const* PersistentRangeMap<K,V>::First( NodePtr const& tree )
+{
+    Node const* node { tree.get() };
+
+    while( node && node->left )
+    {
+        node = node->left.get();
+    }
+
+    return node;
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::Node const* PersistentRangeMap<K,V>::Last( NodePtr const& tree )
+{
+    Node const* node { tree.get() };
+
+    while( node && node->right )
+    {
+        node = node->right.get();
+    }
+
+    return node;
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void PersistentRangeMap<K,V>::ForEach( Node const* node, F& fn )
+{
+    auto visit = [&fn]( Node const* visited ){ fn( visited->key, visited->value ); };
+
+    ForEachNode( node, visit );
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void PersistentRangeMap<K,V>::ForEachNode( Node const* node, F& fn )
+{
+    if( !node )
+    {
+        return;
+    }
+
+    ForEachNode( node->left.get(), fn );
+    fn( node );
+    ForEachNode( node->right.get(), fn );
+}
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::CountNodes( Node const* node, std::unordered_set<void const*>& counted, RangeMapMemoryUsage& usage )
+{
+    if( !node || !counted.insert( node ).second )
+    {
+        return;
+    }
+
+    // every node is allocated by 'std::make_shared', together with its reference counts
+    constexpr std::size_t controlBytes { 2 * sizeof(void*) };
+
+    ++usage.boundaries;
+    usage.nodeBytes  += controlBytes + sizeof(Node) - sizeof(K) - sizeof(V);
+    usage.keyBytes   += ObjectBytes( node->key );
+    usage.valueBytes += ObjectBytes( node->value );
+
+    CountNodes( node->left.get(),  counted, usage );
+    CountNodes( node->right.get(), counted, usage );
+}
+
+
+
+template<typename K, typename V>
+bool PersistentRangeMap<K,V>::SameRanges( NodePtr const& lhs, NodePtr const& rhs )
+{
+    if( lhs == rhs )
+    {
+        return true;
+    }
+
+    if( !lhs || !rhs || lhs->count != rhs->count )
+    {
+        return false;
+    }
+
+    if constexpr( IsHashed )
+    {
+        if( lhs->hash != rhs->hash )
+        {
+            return false;
+        }
+    }
+
+    std::vector<Node const*> lhsNodes;
+    lhsNodes.reserve( lhs->count );
+    auto collect = [&lhsNodes]( Node const* node ){ lhsNodes.push_back( node ); };
+    ForEachNode( lhs.get(), collect );
+
+    std::size_t index { 0 };
+    bool        equal { true };
+    auto compare = [&]( Node const* node )
+    {
+        Node const* other { lhsNodes[index++] };
+        equal = equal && !(node->key < other->key) && !(other->key < node->key) && node->value == other->value;
+    };
+    ForEachNode( rhs.get(), compare );
+
+    return equal;
+}
+
+
+
+template<typename K, typename V>
+std::uint64_t PersistentRangeMap<K,V>::EntryHash( K const& key, V const& value )
+{
+    // splitmix64 finalizer, so that similar keys and values, like consecutive integers, spread over all bits
+    auto mix = []( std::uint64_t x )
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    };
+
+    return mix( mix( std::hash<K>{}( key ) ) + std::hash<V>{}( value ) );
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::RangeSummary PersistentRangeMap<K,V>::SummaryBefore( NodePtr const& tree, K const* key )
+{
+    RangeSummary summary;
+    Node const*  node { tree.get() };
+
+    while( node )
+    {
+        if( key && !(node->key < *key) )
+        {
+            node = node->left.get();
+        }
+        else
+        {
+            // this node and its left subtree are before 'key'
+            summary.count += 1 + (node->left ? node->left->count : 0);
+            summary.hash  += EntryHash( node->key, node->value ) + (node->left ? node->left->hash : 0);
+            node = node->right.get();
+        }
+    }
+
+    return summary;
+}
+
+
+
+template<typename K, typename V>
+typename PersistentRangeMap<K,V>::RangeSummary PersistentRangeMap<K,V>::SummaryOf( NodePtr const& tree, K const* keyBegin, K const* keyEnd )
+{
+    const RangeSummary end   { SummaryBefore( tree, keyEnd ) };
+    const RangeSummary begin { keyBegin ? SummaryBefore( tree, keyBegin ) : RangeSummary{} };
+
+    return { end.count - begin.count, end.hash - begin.hash };
+}
+
+
+
+template<typename K, typename V>
+K const& PersistentRangeMap<K,V>::KeyAtRank( NodePtr const& tree, std::size_t rank )
+{
+    Node const* node { tree.get() };
+
+    while( true )
+    {
+        const std::size_t leftCount { node->left ? node->left->count : 0 };
+
+        if( rank < leftCount )
+        {
+            node = node->left.get();
+        }
+        else if( rank == leftCount )
+        {
+            return node->key;
+        }
+        else
+        {
+            rank -= leftCount + 1;
+            node  = node->right.get();
+        }
+    }
+}
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::CollectBoundaries( Node const* node, K const* keyBegin, K const* keyEnd, std::vector<Node const*>& out )
+{
+    if( !node )
+    {
+        return;
+    }
+
+    const bool isAfterBegin { !keyBegin || !(node->key < *keyBegin) };
+    const bool isBeforeEnd  { !keyEnd   || node->key < *keyEnd };
+
+    if( isAfterBegin )
+    {
+        CollectBoundaries( node->left.get(), keyBegin, keyEnd, out );
+    }
+
+    if( isAfterBegin && isBeforeEnd )
+    {
+        out.push_back( node );
+    }
+
+    if( isBeforeEnd )
+    {
+        CollectBoundaries( node->right.get(), keyBegin, keyEnd, out );
+    }
+}
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::DiffSpans( PersistentRangeMap const& other, K const* keyBegin, K const* keyEnd, std::vector<std::pair<K,K>>& out ) const
+{
+    const RangeSummary lhs { SummaryOf( mRoot,       keyBegin, keyEnd ) };
+    const RangeSummary rhs { SummaryOf( other.mRoot, keyBegin, keyEnd ) };
+
+    if( lhs.count == rhs.count && lhs.hash == rhs.hash )
+    {
+        return;
+    }
+
+    // few boundaries left, compare them directly
+    constexpr std::size_t maxCompared { 16 };
+    if( lhs.count + rhs.count <= maxCompared )
+    {
+        CompareSpans( other, keyBegin, keyEnd, out );
+        return;
+    }
+
+    // halve the key range at the middle boundary of the side with more boundaries, the pivot is
+    // greater than 'keyBegin' since there are several boundaries before it in the key range
+    NodePtr const&    tree  { lhs.count >= rhs.count ? mRoot : other.mRoot };
+    const std::size_t count { std::max( lhs.count, rhs.count ) };
+    const std::size_t first { keyBegin ? SummaryBefore( tree, keyBegin ).count : 0 };
+
+    K const& pivot { KeyAtRank( tree, first + count / 2 ) };
+
+    DiffSpans( other, keyBegin, &pivot, out );
+    DiffSpans( other, &pivot,   keyEnd, out );
+}
+
+
+
+template<typename K, typename V>
+void PersistentRangeMap<K,V>::CompareSpans( PersistentRangeMap const& other, K const* keyBegin, K const* keyEnd, std::vector<std::pair<K,K>>& out ) const
+{
+    std::vector<Node const*> lhsNodes;
+    std::vector<Node const*> rhsNodes;
+    CollectBoundaries( mRoot.get(),       keyBegin, keyEnd, lhsNodes );
+    CollectBoundaries( other.mRoot.get(), keyBegin, keyEnd, rhsNodes );
+
+    // Walk the boundaries of both sides in key order. Keys before the first boundary and after
+    // the last one hold the default value on both sides, so a differing segment always has a
+    // start and an end key.
+    V const* lhsValue  { keyBegin ? &(*this)[*keyBegin] : &mDefaultVal };
+    V const* rhsValue  { keyBegin ? &other[*keyBegin]   : &other.mDefaultVal };
+    K const* spanBegin { keyBegin };
+
+    auto addSpan = [&out]( K const& spanStart, K const& spanEnd )
+    {
+        if( !out.empty() && !(out.back().second < spanStart) && !(spanStart < out.back().second) )
+        {
+            out.back().second = spanEnd; // continues the span found in the previous key range
+        }
+        else
+        {
+            out.emplace_back( spanStart, spanEnd );
+        }
+    };
+
+    std::size_t lhsPos { 0 };
+    std::size_t rhsPos { 0 };
+    while( lhsPos < lhsNodes.size() || rhsPos < rhsNodes.size() )
+    {
+        const bool takeLhs { rhsPos == rhsNodes.size() || (lhsPos < lhsNodes.size() && !(rhsNodes[rhsPos]->key < lhsNodes[lhsPos]->key)) };
+        K const&   next    { takeLhs ? lhsNodes[lhsPos]->key : rhsNodes[rhsPos]->key };
+
+        if( spanBegin && *spanBegin < next && !(*lhsValue == *rhsValue) )
+        {
+            addSpan( *spanBegin, next );
+        }
+
+        if( lhsPos < lhsNodes.size() && !(next < lhsNodes[lhsPos]->key) )
+        {
+            lhsValue = &lhsNodes[lhsPos++]->value;
+        }
+        if( rhsPos < rhsNodes.size() && !(next < rhsNodes[rhsPos]->key) )
+        {
+            rhsValue = &rhsNodes[rhsPos++]->value;
+        }
+
+        spanBegin = &next;
+    }
+
+    if( !(*lhsValue == *rhsValue) )
+    {
+        addSpan( *spanBegin, *keyEnd );
+    }
+}
@@ -3,6 +3,16 @@
 #include <map>
 #include <type_traits>
 #include <cassert>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <algorithm>
+#include <concepts>
+#include <utility>
+#include <functional>
+#include <span>
+
+#include "RangeMap/MemoryUsage.h"
 
 
 template<typename T>
@@ -19,6 +29,64 @@ concept is_equality_comparable =
         { a == b } -> std::same_as<bool>;
     };
 
+template<typename T>
+concept is_addable =
+    requires(T a, T b)
+    {
+        { a + b } -> std::convertible_to<T>;
+    };
+
+template<typename T>
+concept is_subtractable =
+    requires(T a, T b)
+    {
+        { a - b } -> std::convertible_to<T>;
+    };
+
+template<typename T>
+concept is_hashable =
+    requires(T a)
+    {
+        { std::hash<T>{}(a) } -> std::convertible_to<std::size_t>;
+    };
+
+template<typename C>
+concept is_transparent_comparator =
+    requires
+    {
+        typename C::is_transparent;
+    };
+
+
+/**
+ * @brief A single net edit to the stored range boundaries of a RangeMap, as recorded 
+ *        by its change log.
+ */
+template<typename K, typename V>
+struct RangeMapChange
+{
+    enum class Kind { Added, Changed, Removed };
+
+    std::uint64_t    version; // Version of the map that the edit belongs to
+    Kind             kind;    // What happened to the boundary at 'key'
+    K                key;     // The boundary that was edited
+    std::optional<V> value;   // The new value of the boundary, empty when 'kind' is 'Removed'
+};
+
+
+
+/**
+ * @brief All edits needed to bring a RangeMap from version 'fromVersion' to 'toVersion'.
+ */
+template<typename K, typename V>
+struct RangeMapDelta
+{
+    std::uint64_t                     fromVersion;
+    std::uint64_t                     toVersion;
+    std::vector<RangeMapChange<K, V>> changes;     // Ordered by version
+};
+
+
 
 /**
  * @brief A container that associates ranges of value 'K' with values of 'V' in a memory and time 
@@ -26,13 +94,16 @@ concept is_equality_comparable =
  *        When looking up a value 'K', that falls inside a range, its value 'V' is returned, 
  *        otherwise a default value 'V' is returned (set in constructor).
  * 
- * @tparam K  The key type, must be copyable, assignable and less-than comparable via operator<
- * @tparam V  The value type, must be copyable, assignable and equality-comparable via operator==
+ * @tparam K        The key type, must be copyable, assignable and ordered by 'Compare'
+ * @tparam V        The value type, must be copyable, assignable and equality-comparable via operator==
+ * @tparam Compare  The strict weak ordering of the keys, 'operator<' by default. When it is 
+ *                  transparent (like 'std::less<>'), keys of other types that it can compare
+ *                  with 'K' can be used for lookups and assignments.
  */
-template<typename K, typename V>
+template<typename K, typename V, typename Compare = std::less<K>>
     requires std::is_copy_assignable<K>::value &&
              std::is_copy_constructible<K>::value &&
-                  is_less_than_comparable<K> &&
+                  std::strict_weak_order<Compare, K const&, K const&> &&
 
              std::is_copy_assignable<V>::value &&
              std::is_copy_constructible<V>::value &&
@@ -53,6 +124,29 @@ class RangeMap
 
 
 
+    /**
+     * @brief Construct a new Range Map object where the whole range of K
+     *        is associated with value 'dafaultVal', and keys are ordered by 'compare'.
+     */
+    RangeMap( V const& dafaultVal, Compare const& compare )
+    : mDefaultVal { dafaultVal }
+    , mCompare    { compare }
+    , mMap        { compare }
+    {}
+
+
+
+    /**
+     * @brief Copy a Range Map object. The value index, if enabled, is rebuilt for the copy.
+     */
+    RangeMap( RangeMap const& other );
+
+
+
+    RangeMap( RangeMap&& other ) = default;
+
+
+
     /**
      * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[, overwriting 
      *        any previous values which overlap with this range. Ranges where 
@@ -68,6 +162,52 @@ class RangeMap
 
 
 
+    /**
+     * @brief Same as 'assign()' above, for keys of another type than 'K' when 'Compare' 
+     *        is transparent. A 'K' is only constructed from 'keyBegin' or 'keyEnd' when 
+     *        it has to be stored as a range boundary.
+     */
+    template<typename KeyArg>
+        requires is_transparent_comparator<Compare> && std::constructible_from<K, KeyArg const&>
+    void assign( KeyArg const& keyBegin, KeyArg const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Transforms the values of range ['keyBegin', 'keyEnd'[ in place, by calling 'fn'
+     *        on the value of every range that overlaps it (including ranges holding the 
+     *        default value). Ranges are only split at 'keyBegin' and 'keyEnd', and neighbouring
+     *        ranges that end up with equal values are merged, keeping the container canonical.
+     *        Ranges where 'keyBegin' < 'keyEnd' is false are ignored.
+     *        The runtime for this call is O(log N + k), where k is the number of ranges
+     *        overlapping ['keyBegin', 'keyEnd'[
+     * 
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range, which is excluded from the range.
+     * @param fn        Callable as 'fn(V&)', modifies the value it is given.
+     */
+    template<typename F>
+        requires std::invocable<F&, V&>
+    void apply( K const& keyBegin, K const& keyEnd, F fn );
+
+
+
+    /**
+     * @brief Associate 'keyVal' to the parts of range ['keyBegin', 'keyEnd'[ whose current 
+     *        value satisfies 'pred', for example to only fill the ranges holding the 
+     *        default value. Has the same runtime as 'apply()'.
+     * 
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range, which is excluded from the range.
+     * @param pred      Callable as 'pred(V const&)', returns true for values to overwrite.
+     * @param keyVal    The value to assign.
+     */
+    template<typename P>
+        requires std::predicate<P&, V const&>
+    void assign_if( K const& keyBegin, K const& keyEnd, P pred, V const& keyVal );
+
+
+
     /**
      * @brief Does a lookup of the value associated with 'key'
      * 
@@ -78,15 +218,222 @@ class RangeMap
 
 
 
+    /**
+     * @brief Same as 'operator[]' above, for keys of another type than 'K' when 'Compare'
+     *        is transparent, so that no 'K' needs to be constructed for the lookup.
+     */
+    template<typename KeyArg>
+        requires is_transparent_comparator<Compare>
+    V const& operator[]( KeyArg const& key ) const;
+
+
+
     /**
      * @brief Return the underlying map container used to store the ranges. Modify 
      *        at own risk!
      */
-    std::map<K,V>& data();
+    std::map<K,V,Compare>& data();
+
+
+
+    /**
+     * @brief Same as 'data()' above, for read-only access to the ranges.
+     */
+    std::map<K,V,Compare> const& data() const;
+
+
+
+    /**
+     * @brief Returns the value of the keys outside all ranges, as set in the constructor.
+     */
+    V const& default_value() const;
+
+
+
+    /**
+     * @brief Copies the stored range boundaries into two parallel arrays, in key order, 
+     *        where 'keys[i]' is the start of a range holding 'proj(value)' in 'values[i]'.
+     *        Each range ends where the next begins, and the last one (the default value)
+     *        is unbounded. Use a projection to write value IDs instead of values.
+     * 
+     * @param keys    Receives the range boundaries, should have room for 'data().size()' keys.
+     * @param values  Receives the projected values, should have room for as many values.
+     * @param proj    Callable as 'proj(V const&)', converts a value to the type of 'values'.
+     * @return        The number of ranges written, limited by the size of the buffers.
+     */
+    template<typename Out, typename Proj = std::identity>
+        requires std::is_assignable_v<Out&, std::invoke_result_t<Proj&, V const&>>
+    std::size_t export_columns( std::span<K> keys, std::span<Out> values, Proj proj = {} ) const;
+
+
+
+    /**
+     * @brief Same as 'export_columns()' above, but only for the ranges overlapping 
+     *        ['keyBegin', 'keyEnd'[, clipped to it. The first range starts at 'keyBegin', 
+     *        and the last one ends at 'keyEnd'. The runtime is O(log N + k).
+     * 
+     * @return  The number of ranges written, limited by the size of the buffers. Use 
+     *          'column_count()' to size the buffers.
+     */
+    template<typename Out, typename Proj = std::identity>
+        requires std::is_assignable_v<Out&, std::invoke_result_t<Proj&, V const&>>
+    std::size_t export_columns( K const& keyBegin, K const& keyEnd, std::span<K> keys, std::span<Out> values, Proj proj = {} ) const;
+
+
+
+    /**
+     * @brief Writes the length of each range exported by the clipped 'export_columns()',
+     *        'keyEnd' - 'keyBegin' for the ranges clipped to ['keyBegin', 'keyEnd'[.
+     * 
+     * @return  The number of lengths written, limited by the size of 'lengths'.
+     */
+    std::size_t export_lengths( K const& keyBegin, K const& keyEnd, std::span<K> lengths ) const
+        requires is_subtractable<K>;
+
+
+
+    /**
+     * @brief Returns the number of ranges overlapping ['keyBegin', 'keyEnd'[, which is the
+     *        number of elements the clipped 'export_columns()' writes.
+     */
+    std::size_t column_count( K const& keyBegin, K const& keyEnd ) const;
+
+
+
+    /**
+     * @brief Returns the current version of the container. The version is incremented
+     *        by every valid call to 'assign()', 'apply()' and 'assign_if()', once per range
+     *        for 'replace_value()', and set to 'delta.toVersion' by 'apply_delta()'. Edits
+     *        done through 'data()' do not change it.
+     */
+    std::uint64_t version() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the stored ranges, with the change log and the value
+     *        index counted as extra bytes. Heap memory owned by keys and values is counted
+     *        through 'RangeMapHeapBytes'. The runtime is O(N).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+    /**
+     * @brief Start recording the net boundary edits done by 'assign()', so that they can
+     *        be retrieved with 'changes_since()'. Changes done through 'data()' are not 
+     *        recorded.
+     */
+    void enable_change_log();
+
+
+
+    /**
+     * @brief Stop recording edits and discard the recorded change log.
+     */
+    void disable_change_log();
+
+
+
+    /**
+     * @brief Returns the edits done after version 'version'. The runtime is O(log L + C), 
+     *        where L is the size of the change log and C the number of returned changes.
+     * 
+     * @param version  The version the caller is synchronized to.
+     * @return         The delta from 'version' to the current version, or nothing if the 
+     *                 change log does not reach back to 'version' (log disabled, trimmed
+     *                 or 'version' is newer than the container).
+     */
+    std::optional<RangeMapDelta<K,V>> changes_since( std::uint64_t version ) const;
+
+
+
+    /**
+     * @brief Discards recorded edits up to and including version 'version', for example
+     *        once all followers have applied them.
+     */
+    void trim_change_log( std::uint64_t version );
+
+
+
+    /**
+     * @brief Applies a delta produced by 'changes_since()' of another container, making 
+     *        this container equal to the other container at version 'delta.toVersion'.
+     *        Deltas that overlap already applied versions are accepted, since re-applying
+     *        an edit is idempotent.
+     * 
+     * @param delta  The delta to apply.
+     * @return       false, and the container is left unchanged, if the delta does not 
+     *               cover the current version of this container.
+     */
+    bool apply_delta( RangeMapDelta<K,V> const& delta );
+
+
+
+    /**
+     * @brief Start maintaining an index from values to the ranges holding them, used by
+     *        'ranges_of()' and 'replace_value()'. The index is built in O(N log N) and then 
+     *        kept up to date by every edit. Edits done through 'data()' are not tracked
+     *        and leave the index inconsistent.
+     */
+    void enable_value_index()
+        requires is_less_than_comparable<V>;
+
+
+
+    /**
+     * @brief Stop maintaining the value index and discard it.
+     */
+    void disable_value_index();
+
+
+
+    /**
+     * @brief Returns the ranges ['begin', 'end'[ that hold value 'value', in key order. Only 
+     *        ranges that begin at a stored boundary are returned, so the unbounded ranges of 
+     *        the default value before the first and after the last boundary are not. Requires 
+     *        the value index, and runs in O(log M + k), where M is the number of distinct 
+     *        values and k the number of returned ranges.
+     */
+    std::vector<std::pair<K,K>> ranges_of( V const& value ) const
+        requires is_less_than_comparable<V>;
+
+
+
+    /**
+     * @brief Associate 'newValue' to all ranges returned by 'ranges_of( oldValue )'. Requires
+     *        the value index, and runs in O(k log N).
+     */
+    void replace_value( V const& oldValue, V const& newValue )
+        requires is_less_than_comparable<V>;
 
 
 
   private:
+    /**
+     * @brief Implements 'assign()' for keys of type 'KeyArg'.
+     */
+    template<typename KeyArg>
+    void AssignRange( KeyArg const& keyBegin, KeyArg const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Implements 'operator[]' for keys of type 'KeyArg'.
+     */
+    template<typename KeyArg>
+    V const& Lookup( KeyArg const& key ) const;
+
+
+
+    /**
+     * @brief Returns true if key 'lhs' is ordered before key 'rhs' by 'Compare'.
+     */
+    template<typename Lhs, typename Rhs>
+    bool KeyLess( Lhs const& lhs, Rhs const& rhs ) const;
+
+
+
     /**
      * @brief Inserts the key that marks the beginning of a range and returns the iterator 
      * 		  position for the insertion. If the insertion position is at the start of 
@@ -106,26 +453,122 @@ class RangeMap
      * @param keyBeginPos  The upper bound position of 'keyBegin' in 'mMap' (hint)
      * @return             The iterator position for inserted 'keyBegin'
      */
-    typename std::map<K, V>::iterator InsertKeyBegin( K const& keyBegin, V const& keyVal, typename std::map<K,V>::iterator const keyBeginPos );
+    template<typename KeyArg>
+    typename std::map<K,V,Compare>::iterator InsertKeyBegin( KeyArg const& keyBegin, V const& keyVal, typename std::map<K,V,Compare>::iterator const keyBeginPos );
+
+
+
+    /**
+     * @brief Makes sure a range begins at 'key', by inserting a map element with the value
+     *        'key' currently has if needed. This may leave the container non-canonical.
+     * 
+     * @param key  Where a range should begin.
+     * @return     The iterator position of the map element with key 'key'.
+     */
+    typename std::map<K,V,Compare>::iterator SplitAt( K const& key );
+
+
+
+    /**
+     * @brief Removes the map elements in ['first', 'last'] which hold the same value as 
+     *        the range before them, making that part of the container canonical again.
+     */
+    void Coalesce( typename std::map<K,V,Compare>::iterator first, typename std::map<K,V,Compare>::iterator last );
+
+
+
+    /**
+     * @brief Returns a copy of the map elements with keys in ['keyBegin', 'keyEnd'], 
+     *        which are the only elements an assignment to ['keyBegin', 'keyEnd'[ can edit.
+     */
+    template<typename KeyArg>
+    std::vector<std::pair<K,V>> CopyElements( KeyArg const& keyBegin, KeyArg const& keyEnd ) const;
+
+
+
+    /**
+     * @brief Returns true if edits must be tracked, for the change log or the value index.
+     */
+    bool IsTrackingChanges() const;
+
+
+
+    /**
+     * @brief Compares the elements in ['keyBegin', 'keyEnd'] with 'before', a copy taken
+     *        with 'CopyElements()' prior to an edit, and appends the differences to the 
+     *        change log and applies them to the value index.
+     */
+    template<typename KeyArg>
+    void TrackChanges( KeyArg const& keyBegin, KeyArg const& keyEnd, std::vector<std::pair<K,V>> const& before );
+
+
+
+    /**
+     * @brief Adds the map element at 'pos' to the value index, if it is enabled.
+     */
+    void IndexInsert( typename std::map<K,V,Compare>::iterator pos );
+
+
+
+    /**
+     * @brief Removes boundary 'key', which held value 'value', from the value index, if it is enabled.
+     */
+    void IndexErase( K const& key, V const& value );
 
 
     // Member variables
-    const V       mDefaultVal; // Default value for values of 'K' that fall outside ranges
-    std::map<K,V> mMap;        // Container used for storing the ranges
+    const V                         mDefaultVal; // Default value for values of 'K' that fall outside ranges
+    [[no_unique_address]] Compare   mCompare;    // Orders the keys, a copy of the one of 'mMap' that is not copied on every comparison
+    std::map<K,V,Compare>           mMap;        // Container used for storing the ranges
+
+    std::uint64_t                     mVersion          { 0 };     // Incremented by each valid edit, see 'version()'
+    bool                              mChangeLogEnabled { false };
+    std::uint64_t                     mChangeLogBase    { 0 };     // Oldest version 'mChangeLog' can produce a delta from
+    std::vector<RangeMapChange<K, V>> mChangeLog;                  // Recorded edits, ordered by version
+
+    using BoundaryIndex = std::map<K, typename std::map<K,V,Compare>::iterator, Compare>;
+
+    bool                           mValueIndexEnabled { false };
+    std::map<V, BoundaryIndex>     mValueIndex;                    // The boundaries of 'mMap' holding each value
 };
 
 
 
 
-template<typename K, typename V>
-void RangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    AssignRange( keyBegin, keyEnd, keyVal );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+    requires is_transparent_comparator<Compare> && std::constructible_from<K, KeyArg const&>
+void RangeMap<K,V,Compare>::assign( KeyArg const& keyBegin, KeyArg const& keyEnd, V const& keyVal )
+{
+    AssignRange( keyBegin, keyEnd, keyVal );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+void RangeMap<K,V,Compare>::AssignRange( KeyArg const& keyBegin, KeyArg const& keyEnd, V const& keyVal )
 {
     // ignore invalid range
-    if( !(keyBegin < keyEnd) )
+    if( !KeyLess(keyBegin, keyEnd) )
     {
         return;
     }
 
+    std::vector<std::pair<K,V>> elementsBefore;
+    if( IsTrackingChanges() )
+    {
+        elementsBefore = CopyElements( keyBegin, keyEnd );
+    }
+
     // Find key positions and values in map:
     //
     //        keyBegin      keyEnd
@@ -146,11 +589,11 @@ void RangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal
     auto keyEndPos = keyBeginPos; 
     while( keyEndPos != mMap.end() )
     {
-        if( (keyEndPos->first < keyEnd) )
+        if( KeyLess(keyEndPos->first, keyEnd) )
         {
             ++keyEndPos;
         }
-        else if( keyEnd < keyEndPos->first )
+        else if( KeyLess(keyEnd, keyEndPos->first) )
         {
             break;
         }
@@ -182,14 +625,14 @@ void RangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal
 
         if( !endRangeValueEqualKeyVal )
         {
-            keyEndPos = mMap.insert_or_assign( keyEndPos, keyEnd, curRangeValue );  // continue previous range, right after new range
+            keyEndPos = mMap.insert_or_assign( keyEndPos, K(keyEnd), curRangeValue );  // continue previous range, right after new range
         }
     }
     else
     {
         if( !(mDefaultVal == keyVal) )
         {
-            keyEndPos = mMap.insert_or_assign( keyEndPos, keyEnd, mDefaultVal );
+            keyEndPos = mMap.insert_or_assign( keyEndPos, K(keyEnd), mDefaultVal );
         }
     }
 
@@ -199,7 +642,7 @@ void RangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal
         if( !beginRangeValueEqualKeyVal )
         {
             // update upper bound in case insertion of 'keyEnd' changed the bound for 'keyBegin'
-            if( keyEndPos != mMap.end() && keyEndPos->first < keyBeginPos->first )
+            if( keyEndPos != mMap.end() && KeyLess(keyEndPos->first, keyBeginPos->first) )
             {
                 keyBeginPos = keyEndPos;
             }
@@ -216,7 +659,7 @@ void RangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal
         if( !(mDefaultVal == keyVal) )
         {
             // update upper bound in case insertion of 'keyEnd' changed the bound for 'keyBegin'
-            if( keyBeginPos == mMap.end() || (keyEndPos != mMap.end() && keyEndPos->first < keyBeginPos->first) )
+            if( keyBeginPos == mMap.end() || (keyEndPos != mMap.end() && KeyLess(keyEndPos->first, keyBeginPos->first)) )
             {
                 keyBeginPos = keyEndPos;
             }
@@ -238,41 +681,146 @@ void RangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal
             mMap.erase( std::next(keyBeginPos), keyEndPos);
         }
     }
+
+    ++mVersion;
+
+    if( IsTrackingChanges() )
+    {
+        TrackChanges( keyBegin, keyEnd, elementsBefore );
+    }
 }
 
 
 
-template<typename K, typename V>
-V const& RangeMap<K,V>::operator[]( K const& key ) const
+template<typename K, typename V, typename Compare>
+template<typename F>
+    requires std::invocable<F&, V&>
+void RangeMap<K,V,Compare>::apply( K const& keyBegin, K const& keyEnd, F fn )
 {
-    auto it = mMap.upper_bound(key);
+    // ignore invalid range
+    if( !KeyLess(keyBegin, keyEnd) )
+    {
+        return;
+    }
 
-    if( it == mMap.begin() )
+    std::vector<std::pair<K,V>> elementsBefore;
+    if( IsTrackingChanges() )
     {
-        return mDefaultVal;
+        elementsBefore = CopyElements( keyBegin, keyEnd );
     }
-    else
+
+    auto keyBeginPos { SplitAt( keyBegin ) };
+    auto keyEndPos   { SplitAt( keyEnd )   };
+
+    for( auto it = keyBeginPos; it != keyEndPos; ++it )
     {
-        return (--it)->second;
+        fn( it->second );
     }
-}
 
+    Coalesce( keyBeginPos, keyEndPos );
 
+    ++mVersion;
 
-template<typename K, typename V>
-std::map<K,V>& RangeMap<K,V>::data()
-{
-     return mMap;
+    if( IsTrackingChanges() )
+    {
+        TrackChanges( keyBegin, keyEnd, elementsBefore );
+    }
 }
 
 
 
-template<typename K, typename V>
-typename std::map<K, V>::iterator RangeMap<K,V>::InsertKeyBegin( K const& keyBegin, V const& keyVal, typename std::map<K,V>::iterator const keyBeginPos )
+template<typename K, typename V, typename Compare>
+template<typename P>
+    requires std::predicate<P&, V const&>
+void RangeMap<K,V,Compare>::assign_if( K const& keyBegin, K const& keyEnd, P pred, V const& keyVal )
 {
-    typename std::map<K, V>::iterator out;
-
-    auto insertionPos { mMap.insert( keyBeginPos, {keyBegin, keyVal} ) };
+    apply( keyBegin, keyEnd, [&pred, &keyVal]( V& value )
+    {
+        if( pred( std::as_const(value) ) )
+        {
+            value = keyVal;
+        }
+    });
+}
+
+
+
+template<typename K, typename V, typename Compare>
+V const& RangeMap<K,V,Compare>::operator[]( K const& key ) const
+{
+    return Lookup( key );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+    requires is_transparent_comparator<Compare>
+V const& RangeMap<K,V,Compare>::operator[]( KeyArg const& key ) const
+{
+    return Lookup( key );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+V const& RangeMap<K,V,Compare>::Lookup( KeyArg const& key ) const
+{
+    auto it = mMap.upper_bound(key);
+
+    if( it == mMap.begin() )
+    {
+        return mDefaultVal;
+    }
+    else
+    {
+        return (--it)->second;
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::map<K,V,Compare>& RangeMap<K,V,Compare>::data()
+{
+     return mMap;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::map<K,V,Compare> const& RangeMap<K,V,Compare>::data() const
+{
+     return mMap;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+V const& RangeMap<K,V,Compare>::default_value() const
+{
+     return mDefaultVal;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename Lhs, typename Rhs>
+bool RangeMap<K,V,Compare>::KeyLess( Lhs const& lhs, Rhs const& rhs ) const
+{
+    return mCompare( lhs, rhs );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+typename std::map<K,V,Compare>::iterator RangeMap<K,V,Compare>::InsertKeyBegin( KeyArg const& keyBegin, V const& keyVal, typename std::map<K,V,Compare>::iterator const keyBeginPos )
+{
+    typename std::map<K,V,Compare>::iterator out;
+
+    auto insertionPos { mMap.insert( keyBeginPos, {K(keyBegin), keyVal} ) };
     
     assert( ((std::next(insertionPos) == mMap.end()) || (std::next(insertionPos) == keyBeginPos)) && ("std::map insert hint was not correct!") );
 
@@ -289,3 +837,468 @@ typename std::map<K, V>::iterator RangeMap<K,V>::InsertKeyBegin( K const& keyBeg
 
     return out;
 }
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename Out, typename Proj>
+    requires std::is_assignable_v<Out&, std::invoke_result_t<Proj&, V const&>>
+std::size_t RangeMap<K,V,Compare>::export_columns( std::span<K> keys, std::span<Out> values, Proj proj ) const
+{
+    const std::size_t count { std::min( { mMap.size(), keys.size(), values.size() } ) };
+
+    auto it = mMap.begin();
+    for( std::size_t index{0}; index < count; ++index, ++it )
+    {
+        keys[index]   = it->first;
+        values[index] = proj( it->second );
+    }
+
+    return count;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename Out, typename Proj>
+    requires std::is_assignable_v<Out&, std::invoke_result_t<Proj&, V const&>>
+std::size_t RangeMap<K,V,Compare>::export_columns( K const& keyBegin, K const& keyEnd, std::span<K> keys, std::span<Out> values, Proj proj ) const
+{
+    const std::size_t count { std::min( { column_count( keyBegin, keyEnd ), keys.size(), values.size() } ) };
+
+    if( count == 0 )
+    {
+        return 0;
+    }
+
+    // the first range starts at 'keyBegin', the others at the boundaries after it
+    keys[0]   = keyBegin;
+    values[0] = proj( Lookup( keyBegin ) );
+
+    auto it = mMap.upper_bound( keyBegin );
+    for( std::size_t index{1}; index < count; ++index, ++it )
+    {
+        keys[index]   = it->first;
+        values[index] = proj( it->second );
+    }
+
+    return count;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::size_t RangeMap<K,V,Compare>::export_lengths( K const& keyBegin, K const& keyEnd, std::span<K> lengths ) const
+    requires is_subtractable<K>
+{
+    const std::size_t count { std::min( column_count( keyBegin, keyEnd ), lengths.size() ) };
+
+    K    rangeBegin { keyBegin };
+    auto it         { mMap.upper_bound( keyBegin ) };
+    for( std::size_t index{0}; index < count; ++index, ++it )
+    {
+        const K& rangeEnd { (it != mMap.end() && KeyLess( it->first, keyEnd )) ? it->first : keyEnd };
+
+        lengths[index] = rangeEnd - rangeBegin;
+        rangeBegin     = rangeEnd;
+    }
+
+    return count;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::size_t RangeMap<K,V,Compare>::column_count( K const& keyBegin, K const& keyEnd ) const
+{
+    if( !KeyLess( keyBegin, keyEnd ) )
+    {
+        return 0;
+    }
+
+    // one range starting at 'keyBegin', plus one for each boundary in ]'keyBegin', 'keyEnd'[
+    return 1 + std::size_t( std::distance( mMap.upper_bound( keyBegin ), mMap.lower_bound( keyEnd ) ) );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::uint64_t RangeMap<K,V,Compare>::version() const
+{
+    return mVersion;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+RangeMapMemoryUsage RangeMap<K,V,Compare>::memory_usage() const
+{
+    using Element = typename std::map<K,V,Compare>::value_type;
+
+    RangeMapMemoryUsage usage;
+    usage.boundaries = mMap.size();
+    usage.nodeBytes  = mMap.size() * (TreeNodeBytes<Element>() - sizeof(K) - sizeof(V));
+
+    for( auto const& [key, value] : mMap )
+    {
+        usage.keyBytes   += ObjectBytes( key );
+        usage.valueBytes += ObjectBytes( value );
+    }
+
+    usage.extraBytes += mChangeLog.capacity() * sizeof(RangeMapChange<K,V>);
+    for( auto const& change : mChangeLog )
+    {
+        usage.extraBytes += RangeMapHeapBytes<K>{}( change.key ) + RangeMapHeapBytes<std::optional<V>>{}( change.value );
+    }
+
+    for( auto const& [value, boundaries] : mValueIndex )
+    {
+        usage.extraBytes += TreeNodeBytes<std::pair<const V, BoundaryIndex>>() + RangeMapHeapBytes<V>{}( value );
+
+        for( auto const& entry : boundaries )
+        {
+            usage.extraBytes += TreeNodeBytes<typename BoundaryIndex::value_type>() + RangeMapHeapBytes<K>{}( entry.first );
+        }
+    }
+
+    return usage;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::enable_change_log()
+{
+    if( !mChangeLogEnabled )
+    {
+        mChangeLogEnabled = true;
+        mChangeLogBase    = mVersion;
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::disable_change_log()
+{
+    mChangeLogEnabled = false;
+    mChangeLog.clear();
+    mChangeLog.shrink_to_fit();
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::optional<RangeMapDelta<K,V>> RangeMap<K,V,Compare>::changes_since( std::uint64_t version ) const
+{
+    if( !mChangeLogEnabled || version < mChangeLogBase || mVersion < version )
+    {
+        return std::nullopt;
+    }
+
+    auto first = std::upper_bound( mChangeLog.begin(), mChangeLog.end(), version,
+                                   []( std::uint64_t v, RangeMapChange<K,V> const& change ){ return v < change.version; } );
+
+    return RangeMapDelta<K,V> { version, mVersion, std::vector<RangeMapChange<K,V>>( first, mChangeLog.end() ) };
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::trim_change_log( std::uint64_t version )
+{
+    if( version <= mChangeLogBase )
+    {
+        return;
+    }
+
+    auto last = std::upper_bound( mChangeLog.begin(), mChangeLog.end(), version,
+                                  []( std::uint64_t v, RangeMapChange<K,V> const& change ){ return v < change.version; } );
+
+    mChangeLog.erase( mChangeLog.begin(), last );
+    mChangeLogBase = std::min( version, mVersion );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+bool RangeMap<K,V,Compare>::apply_delta( RangeMapDelta<K,V> const& delta )
+{
+    if( mVersion < delta.fromVersion || delta.toVersion < mVersion )
+    {
+        return false;
+    }
+
+    for( auto const& change : delta.changes )
+    {
+        auto pos { mMap.find( change.key ) };
+        if( pos != mMap.end() )
+        {
+            IndexErase( pos->first, pos->second );
+        }
+
+        if( change.kind == RangeMapChange<K,V>::Kind::Removed )
+        {
+            if( pos != mMap.end() )
+            {
+                mMap.erase( pos );
+            }
+        }
+        else
+        {
+            IndexInsert( mMap.insert_or_assign( pos, change.key, *change.value ) );
+        }
+
+        if( mChangeLogEnabled && mVersion < change.version )
+        {
+            mChangeLog.push_back( change );
+        }
+    }
+
+    mVersion = delta.toVersion;
+
+    return true;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+typename std::map<K,V,Compare>::iterator RangeMap<K,V,Compare>::SplitAt( K const& key )
+{
+    auto pos { mMap.upper_bound(key) };
+
+    if( pos == mMap.begin() )
+    {
+        return mMap.emplace_hint( pos, key, mDefaultVal );
+    }
+
+    auto prevPos { std::prev(pos) };
+    if( !KeyLess(prevPos->first, key) )
+    {
+        return prevPos; // a range already begins at 'key'
+    }
+
+    return mMap.emplace_hint( pos, key, prevPos->second );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::Coalesce( typename std::map<K,V,Compare>::iterator first, typename std::map<K,V,Compare>::iterator last )
+{
+    const auto stop { std::next(last) };
+
+    for( auto it = first; it != stop; )
+    {
+        const V& prevValue { (it == mMap.begin()) ? mDefaultVal : std::prev(it)->second };
+
+        if( it->second == prevValue )
+        {
+            it = mMap.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+std::vector<std::pair<K,V>> RangeMap<K,V,Compare>::CopyElements( KeyArg const& keyBegin, KeyArg const& keyEnd ) const
+{
+    return std::vector<std::pair<K,V>>( mMap.lower_bound(keyBegin), mMap.upper_bound(keyEnd) );
+}
+
+
+
+template<typename K, typename V, typename Compare>
+bool RangeMap<K,V,Compare>::IsTrackingChanges() const
+{
+    return mChangeLogEnabled || mValueIndexEnabled;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+template<typename KeyArg>
+void RangeMap<K,V,Compare>::TrackChanges( KeyArg const& keyBegin, KeyArg const& keyEnd, std::vector<std::pair<K,V>> const& before )
+{
+    using Kind = typename RangeMapChange<K,V>::Kind;
+
+    // Both 'before' and the elements after the edit are sorted by key, so the
+    // differences are found by walking them side by side
+    auto       afterIt  = mMap.lower_bound(keyBegin);
+    auto const afterEnd = mMap.upper_bound(keyEnd);
+    auto       beforeIt = before.begin();
+
+    while( beforeIt != before.end() || afterIt != afterEnd )
+    {
+        if( afterIt == afterEnd || (beforeIt != before.end() && KeyLess(beforeIt->first, afterIt->first)) )
+        {
+            if( mChangeLogEnabled )
+            {
+                mChangeLog.push_back( { mVersion, Kind::Removed, beforeIt->first, std::nullopt } );
+            }
+            IndexErase( beforeIt->first, beforeIt->second );
+            ++beforeIt;
+        }
+        else if( beforeIt == before.end() || KeyLess(afterIt->first, beforeIt->first) )
+        {
+            if( mChangeLogEnabled )
+            {
+                mChangeLog.push_back( { mVersion, Kind::Added, afterIt->first, afterIt->second } );
+            }
+            IndexInsert( afterIt );
+            ++afterIt;
+        }
+        else
+        {
+            if( !(beforeIt->second == afterIt->second) )
+            {
+                if( mChangeLogEnabled )
+                {
+                    mChangeLog.push_back( { mVersion, Kind::Changed, afterIt->first, afterIt->second } );
+                }
+                IndexErase( beforeIt->first, beforeIt->second );
+                IndexInsert( afterIt );
+            }
+            ++beforeIt;
+            ++afterIt;
+        }
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::IndexInsert( typename std::map<K,V,Compare>::iterator pos )
+{
+    if constexpr( is_less_than_comparable<V> )
+    {
+        if( mValueIndexEnabled )
+        {
+            auto boundaries { mValueIndex.try_emplace( pos->second, mCompare ).first };
+            boundaries->second.insert_or_assign( pos->first, pos );
+        }
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::IndexErase( K const& key, V const& value )
+{
+    if constexpr( is_less_than_comparable<V> )
+    {
+        if( mValueIndexEnabled )
+        {
+            auto boundaries { mValueIndex.find( value ) };
+            if( boundaries != mValueIndex.end() )
+            {
+                boundaries->second.erase( key );
+                if( boundaries->second.empty() )
+                {
+                    mValueIndex.erase( boundaries );
+                }
+            }
+        }
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+RangeMap<K,V,Compare>::RangeMap( RangeMap const& other )
+: mDefaultVal       { other.mDefaultVal       }
+, mCompare          { other.mCompare          }
+, mMap              { other.mMap              }
+, mVersion          { other.mVersion          }
+, mChangeLogEnabled { other.mChangeLogEnabled }
+, mChangeLogBase    { other.mChangeLogBase    }
+, mChangeLog        { other.mChangeLog        }
+{
+    // the index of 'other' refers to the elements of 'other.mMap', so build a new one
+    if constexpr( is_less_than_comparable<V> )
+    {
+        if( other.mValueIndexEnabled )
+        {
+            enable_value_index();
+        }
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::enable_value_index()
+    requires is_less_than_comparable<V>
+{
+    if( mValueIndexEnabled )
+    {
+        return;
+    }
+
+    mValueIndexEnabled = true;
+    for( auto pos = mMap.begin(); pos != mMap.end(); ++pos )
+    {
+        IndexInsert( pos );
+    }
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::disable_value_index()
+{
+    mValueIndexEnabled = false;
+    mValueIndex.clear();
+}
+
+
+
+template<typename K, typename V, typename Compare>
+std::vector<std::pair<K,K>> RangeMap<K,V,Compare>::ranges_of( V const& value ) const
+    requires is_less_than_comparable<V>
+{
+    assert( mValueIndexEnabled && "value index is not enabled" );
+
+    std::vector<std::pair<K,K>> out;
+
+    auto boundaries { mValueIndex.find( value ) };
+    if( boundaries == mValueIndex.end() )
+    {
+        return out;
+    }
+
+    for( auto const& [key, pos] : boundaries->second )
+    {
+        auto next { std::next(pos) };
+        if( next != mMap.end() )
+        {
+            out.emplace_back( key, next->first );
+        }
+    }
+
+    return out;
+}
+
+
+
+template<typename K, typename V, typename Compare>
+void RangeMap<K,V,Compare>::replace_value( V const& oldValue, V const& newValue )
+    requires is_less_than_comparable<V>
+{
+    if( oldValue == newValue )
+    {
+        return;
+    }
+
+    // the ranges of 'oldValue' are disjoint, so assigning one does not move the others
+    for( auto const& [keyBegin, keyEnd] : ranges_of( oldValue ) )
+    {
+        assign( keyBegin, keyEnd, newValue );
+    }
+}
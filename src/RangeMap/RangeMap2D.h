@@ -0,0 +1,172 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/PersistentRangeMap.h"
+
+#include <unordered_set>
+
+
+/**
+ * @brief A rectangle of keys, ['keyBegin1', 'keyEnd1'[ x ['keyBegin2', 'keyEnd2'[
+ */
+template<typename K1, typename K2>
+struct RangeRect
+{
+    K1 keyBegin1;
+    K1 keyEnd1;
+    K2 keyBegin2;
+    K2 keyEnd2;
+};
+
+
+
+/**
+ * @brief A two-dimensional range map, where a value 'V' is assigned to rectangles of keys
+ *        (K1, K2). When looking up a point that no assigned rectangle covers, the default
+ *        value is returned.
+ *
+ *        The first dimension is a RangeMap whose values are PersistentRangeMaps over the second
+ *        dimension. Splitting a range of the first dimension copies its inner map in O(1), and
+ *        the inner maps of all ranges a rectangle spans keep sharing the tree nodes that the
+ *        rectangle does not change. Neighbouring ranges of the first dimension whose inner maps
+ *        become equal are merged, so the container stays canonical. Inner maps are compared by
+ *        their content hashes in O(1), see 'PersistentRangeMap::same_content()', so two
+ *        neighbours whose different inner maps have colliding hashes would be merged.
+ *
+ * @tparam K1  The key type of the first dimension, with the same requirements as the key of RangeMap
+ * @tparam K2  The key type of the second dimension, with the same requirements as the key of RangeMap,
+ *             and hashable with 'std::hash'
+ * @tparam V   The value type, with the same requirements as the value of RangeMap, and hashable with 'std::hash'
+ */
+template<typename K1, typename K2, typename V>
+    requires std::is_copy_assignable<K1>::value &&
+             std::is_copy_constructible<K1>::value &&
+                  is_less_than_comparable<K1> &&
+
+             std::is_copy_assignable<K2>::value &&
+             std::is_copy_constructible<K2>::value &&
+                  is_less_than_comparable<K2> &&
+                  is_hashable<K2> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V> &&
+                  is_hashable<V>
+class RangeMap2D
+{
+  public:
+    /**
+     * @brief The ranges of the second dimension held by a range of the first dimension. They
+     *        compare equal by 'same_content()', so that merging equal neighbours is O(1).
+     */
+    class InnerMap : public PersistentRangeMap<K2, V>
+    {
+      public:
+        using PersistentRangeMap<K2, V>::PersistentRangeMap;
+
+        friend bool operator==( InnerMap const& lhs, InnerMap const& rhs )
+        {
+            return lhs.same_content( rhs );
+        }
+    };
+
+
+    /**
+     * @brief Construct a new Range Map 2D object where the whole plane of (K1, K2)
+     *        is associated with value 'defaultVal'.
+     */
+    RangeMap2D( V const& defaultVal )
+    : mOuter { InnerMap { defaultVal } }
+    {}
+
+
+
+    /**
+     * @brief Associate 'keyVal' to rectangle 'rect', overwriting any previous values which
+     *        overlap with it. Empty rectangles are ignored. The runtime for this call is
+     *        O(log N1 + k log N2), where k is the number of ranges of the first dimension
+     *        that the rectangle spans.
+     *
+     * @param rect    The rectangle, which excludes its end keys in both dimensions.
+     * @param keyVal  The value to associate to the rectangle.
+     */
+    void assign( RangeRect<K1, K2> const& rect, V const& keyVal );
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with point ('key1', 'key2').
+     */
+    V const& operator()( K1 const& key1, K2 const& key2 ) const;
+
+
+
+    /**
+     * @brief Return the RangeMap of the first dimension. Modify at own risk!
+     */
+    RangeMap<K1, InnerMap>& data();
+
+
+
+    /**
+     * @brief Returns the memory used by the ranges of both dimensions. Tree nodes shared by
+     *        several inner maps are counted once. The runtime is O(N1 + number of inner nodes).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+  private:
+    // Member variables
+    RangeMap<K1, InnerMap> mOuter; // Ranges of the first dimension, each holding the ranges of the second dimension
+};
+
+
+
+
+template<typename K1, typename K2, typename V>
+void RangeMap2D<K1,K2,V>::assign( RangeRect<K1, K2> const& rect, V const& keyVal )
+{
+    // ignore empty rectangle, the first dimension is checked by 'apply()'
+    if( !(rect.keyBegin2 < rect.keyEnd2) )
+    {
+        return;
+    }
+
+    mOuter.apply( rect.keyBegin1, rect.keyEnd1, [&rect, &keyVal]( InnerMap& inner )
+    {
+        inner.assign( rect.keyBegin2, rect.keyEnd2, keyVal );
+    });
+}
+
+
+
+template<typename K1, typename K2, typename V>
+V const& RangeMap2D<K1,K2,V>::operator()( K1 const& key1, K2 const& key2 ) const
+{
+    return mOuter[key1][key2];
+}
+
+
+
+template<typename K1, typename K2, typename V>
+RangeMap<K1, typename RangeMap2D<K1,K2,V>::InnerMap>& RangeMap2D<K1,K2,V>::data()
+{
+    return mOuter;
+}
+
+
+
+template<typename K1, typename K2, typename V>
+RangeMapMemoryUsage RangeMap2D<K1,K2,V>::memory_usage() const
+{
+    RangeMapMemoryUsage usage { mOuter.memory_usage() };
+
+    std::unordered_set<void const*> counted;
+    for( auto const& [key1, inner] : mOuter.data() )
+    {
+        usage += inner.memory_usage( counted );
+    }
+
+    return usage;
+}
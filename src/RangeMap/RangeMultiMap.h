@@ -0,0 +1,373 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+
+/**
+ * @brief A companion of RangeMap where intervals may overlap: every interval ['keyBegin', 'keyEnd'[
+ *        keeps its own value, and a lookup returns all intervals that cover a key instead of the
+ *        last one assigned.
+ *
+ *        The intervals are stored in a treap ordered by 'keyBegin', where every node also keeps
+ *        the largest 'keyEnd' of its subtree, so subtrees that end before the searched key are
+ *        skipped. Insert and erase are expected O(log N), and a query reporting k intervals
+ *        visits O((k + 1) log N) nodes in the worst case.
+ *
+ * @tparam K  The key type, must be copyable, assignable and less-than comparable via operator<
+ * @tparam V  The value type, must be copyable
+ */
+template<typename K, typename V>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_constructible<V>::value
+class RangeMultiMap
+{
+  public:
+    using Handle = std::uint64_t; // Identifies an inserted interval
+
+
+    /**
+     * @brief Inserts interval ['keyBegin', 'keyEnd'[ with value 'value'. Intervals where
+     *        'keyEnd' is not greater than 'keyBegin' are ignored.
+     *
+     * @return  The handle to erase the interval with, or nothing if it was ignored.
+     */
+    std::optional<Handle> insert( K const& keyBegin, K const& keyEnd, V const& value );
+
+
+
+    /**
+     * @brief Erases the interval identified by 'handle'.
+     *
+     * @return  false if there is no such interval.
+     */
+    bool erase( Handle handle );
+
+
+
+    /**
+     * @brief Calls 'fn(handle, keyBegin, keyEnd, value)' for every interval that contains
+     *        'key', in order of 'keyBegin'.
+     */
+    template<typename F>
+    void stab( K const& key, F&& fn ) const;
+
+
+
+    /**
+     * @brief Calls 'fn(handle, keyBegin, keyEnd, value)' for every interval that overlaps
+     *        ['keyBegin', 'keyEnd'[, in order of 'keyBegin'.
+     */
+    template<typename F>
+    void overlap( K const& keyBegin, K const& keyEnd, F&& fn ) const;
+
+
+
+    /**
+     * @brief Returns the number of stored intervals.
+     */
+    std::size_t size() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the nodes of the tree and by the index of the handles.
+     *        'boundaries' counts the stored intervals, and 'keyBytes' both keys of each of them.
+     *        The runtime is O(N).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+  private:
+    struct Node;
+    using NodePtr = std::unique_ptr<Node>;
+
+    struct Node
+    {
+        K             keyBegin;
+        K             keyEnd;
+        V             value;
+        Handle        handle;   // Orders intervals with equal 'keyBegin'
+        std::uint64_t priority; // Heap order of the treap, a parent has a higher priority than its children
+        K             maxEnd;   // Largest 'keyEnd' in the subtree
+        NodePtr       left;
+        NodePtr       right;
+    };
+
+
+    /**
+     * @brief Returns true if 'node' is ordered before the interval starting at 'keyBegin'
+     *        with handle 'handle'.
+     */
+    static bool IsBefore( Node const& node, K const& keyBegin, Handle handle );
+
+
+    /**
+     * @brief Recomputes 'maxEnd' of 'node' from its interval and its children.
+     */
+    static void Update( Node& node );
+
+
+    /**
+     * @brief Splits 'tree' into the nodes ordered before ('keyBegin', 'handle') and the rest.
+     */
+    static std::pair<NodePtr, NodePtr> Split( NodePtr tree, K const& keyBegin, Handle handle );
+
+
+    /**
+     * @brief Joins two trees, where all nodes in 'lhs' are ordered before all nodes in 'rhs'.
+     */
+    static NodePtr Join( NodePtr lhs, NodePtr rhs );
+
+
+    /**
+     * @brief Reports the intervals of 'node' that begin before 'keyEnd' and end after 'keyBegin'.
+     *        A stabbing query for 'key' is the same as an overlap query for ['key', 'key'], except
+     *        that intervals beginning at 'key' must be reported, hence 'isEndInclusive'.
+     */
+    template<typename F>
+    static void Overlap( Node const* node, K const& keyBegin, K const& keyEnd, bool isEndInclusive, F& fn );
+
+
+    template<typename F>
+    static void ForEachNode( Node const* node, F& fn );
+
+
+    // Member variables
+    NodePtr                           mRoot;
+    std::unordered_map<Handle, K>     mKeyBegins;      // 'keyBegin' of each stored interval, to find it when erasing
+    Handle                            mNextHandle { 1 };
+};
+
+
+
+
+template<typename K, typename V>
+std::optional<typename RangeMultiMap<K,V>::Handle> RangeMultiMap<K,V>::insert( K const& keyBegin, K const& keyEnd, V const& value )
+{
+    // ignore invalid interval
+    if( !(keyBegin < keyEnd) )
+    {
+        return std::nullopt;
+    }
+
+    thread_local std::mt19937_64 generator { std::random_device{}() };
+
+    const Handle handle { mNextHandle++ };
+
+    auto node { std::make_unique<Node>( Node { keyBegin, keyEnd, value, handle, generator(), keyEnd, nullptr, nullptr } ) };
+
+    auto [lhs, rhs] = Split( std::move(mRoot), keyBegin, handle );
+    mRoot = Join( Join( std::move(lhs), std::move(node) ), std::move(rhs) );
+
+    mKeyBegins.emplace( handle, keyBegin );
+
+    return handle;
+}
+
+
+
+template<typename K, typename V>
+bool RangeMultiMap<K,V>::erase( Handle handle )
+{
+    auto it = mKeyBegins.find( handle );
+    if( it == mKeyBegins.end() )
+    {
+        return false;
+    }
+
+    // the interval is the only node ordered between ('keyBegin', 'handle') and ('keyBegin', 'handle' + 1)
+    auto [lhs, rest] = Split( std::move(mRoot), it->second, handle     );
+    auto [mid, rhs]  = Split( std::move(rest),  it->second, handle + 1 );
+    mRoot = Join( std::move(lhs), std::move(rhs) );
+
+    mKeyBegins.erase( it );
+
+    return true;
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void RangeMultiMap<K,V>::stab( K const& key, F&& fn ) const
+{
+    Overlap( mRoot.get(), key, key, true, fn );
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void RangeMultiMap<K,V>::overlap( K const& keyBegin, K const& keyEnd, F&& fn ) const
+{
+    if( keyBegin < keyEnd )
+    {
+        Overlap( mRoot.get(), keyBegin, keyEnd, false, fn );
+    }
+}
+
+
+
+template<typename K, typename V>
+std::size_t RangeMultiMap<K,V>::size() const
+{
+    return mKeyBegins.size();
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage RangeMultiMap<K,V>::memory_usage() const
+{
+    RangeMapMemoryUsage usage;
+    usage.boundaries = size();
+    usage.nodeBytes  = size() * (sizeof(Node) - 2 * sizeof(K) - sizeof(V));
+
+    // the handle index holds a bucket array and one allocated entry per interval
+    usage.nodeBytes += mKeyBegins.bucket_count() * sizeof(void*) +
+                       mKeyBegins.size() * (sizeof(void*) + sizeof(typename decltype(mKeyBegins)::value_type));
+
+    auto count = [&usage]( Node const* node )
+    {
+        usage.nodeBytes  += RangeMapHeapBytes<K>{}( node->maxEnd );
+        usage.nodeBytes  += RangeMapHeapBytes<K>{}( node->keyBegin ); // its copy in the handle index
+        usage.keyBytes   += ObjectBytes( node->keyBegin ) + ObjectBytes( node->keyEnd );
+        usage.valueBytes += ObjectBytes( node->value );
+    };
+    ForEachNode( mRoot.get(), count );
+
+    return usage;
+}
+
+
+
+template<typename K, typename V>
+bool RangeMultiMap<K,V>::IsBefore( Node const& node, K const& keyBegin, Handle handle )
+{
+    if( node.keyBegin < keyBegin ) { return true;  }
+    if( keyBegin < node.keyBegin ) { return false; }
+
+    return node.handle < handle;
+}
+
+
+
+template<typename K, typename V>
+void RangeMultiMap<K,V>::Update( Node& node )
+{
+    node.maxEnd = node.keyEnd;
+
+    if( node.left && node.maxEnd < node.left->maxEnd )
+    {
+        node.maxEnd = node.left->maxEnd;
+    }
+
+    if( node.right && node.maxEnd < node.right->maxEnd )
+    {
+        node.maxEnd = node.right->maxEnd;
+    }
+}
+
+
+
+template<typename K, typename V>
+std::pair<typename RangeMultiMap<K,V>::NodePtr, typename RangeMultiMap<K,V>::NodePtr>
+RangeMultiMap<K,V>::Split( NodePtr tree, K const& keyBegin, Handle handle )
+{
+    if( !tree )
+    {
+        return { nullptr, nullptr };
+    }
+
+    if( IsBefore( *tree, keyBegin, handle ) )
+    {
+        auto [lhs, rhs] = Split( std::move(tree->right), keyBegin, handle );
+        tree->right = std::move(lhs);
+        Update( *tree );
+        return { std::move(tree), std::move(rhs) };
+    }
+    else
+    {
+        auto [lhs, rhs] = Split( std::move(tree->left), keyBegin, handle );
+        tree->left = std::move(rhs);
+        Update( *tree );
+        return { std::move(lhs), std::move(tree) };
+    }
+}
+
+
+
+template<typename K, typename V>
+typename RangeMultiMap<K,V>::NodePtr RangeMultiMap<K,V>::Join( NodePtr lhs, NodePtr rhs )
+{
+    if( !lhs ) { return rhs; }
+    if( !rhs ) { return lhs; }
+
+    if( rhs->priority < lhs->priority )
+    {
+        lhs->right = Join( std::move(lhs->right), std::move(rhs) );
+        Update( *lhs );
+        return lhs;
+    }
+    else
+    {
+        rhs->left = Join( std::move(lhs), std::move(rhs->left) );
+        Update( *rhs );
+        return rhs;
+    }
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void RangeMultiMap<K,V>::Overlap( Node const* node, K const& keyBegin, K const& keyEnd, bool isEndInclusive, F& fn )
+{
+    // skip subtrees where all intervals end at or before 'keyBegin'
+    if( !node || !(keyBegin < node->maxEnd) )
+    {
+        return;
+    }
+
+    Overlap( node->left.get(), keyBegin, keyEnd, isEndInclusive, fn );
+
+    const bool beginsInRange { isEndInclusive ? !(keyEnd < node->keyBegin) : node->keyBegin < keyEnd };
+    if( !beginsInRange )
+    {
+        return; // this interval and all intervals in the right subtree begin after the range
+    }
+
+    if( keyBegin < node->keyEnd )
+    {
+        fn( node->handle, node->keyBegin, node->keyEnd, node->value );
+    }
+
+    Overlap( node->right.get(), keyBegin, keyEnd, isEndInclusive, fn );
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void RangeMultiMap<K,V>::ForEachNode( Node const* node, F& fn )
+{
+    if( !node )
+    {
+        return;
+    }
+
+    ForEachNode( node->left.get(), fn );
+    fn( node );
+    ForEachNode( node->right.get(), fn );
+}
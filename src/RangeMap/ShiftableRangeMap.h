@@ -0,0 +1,570 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+
+
+/**
+ * @brief A variant of RangeMap whose key space can be edited like a text buffer: 'shift()'
+ *        opens a gap at a key and 'remove_span()' cuts a span of keys out, moving all range
+ *        boundaries after it. Both are expected O(log N), independent of the number of
+ *        boundaries that move.
+ *
+ *        The ranges are stored in a treap where every node carries an offset that still has
+ *        to be added to the keys of its whole subtree. Moving all boundaries after a key adds
+ *        to the offset of a single subtree, and the offsets are pushed down to the children
+ *        when the tree is restructured.
+ *
+ *        Keys are moved with the arithmetic of 'K', so shifting boundaries past the largest
+ *        value of 'K' wraps around for unsigned keys and is undefined for signed ones.
+ *
+ * @tparam K  The key type, must be copyable, assignable, less-than comparable via operator<,
+ *            and support operator+ and operator-, with 'K{}' as zero
+ * @tparam V  The value type, must be copyable, assignable and equality-comparable via operator==
+ */
+template<typename K, typename V>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+                  is_addable<K> &&
+                  is_subtractable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V>
+class ShiftableRangeMap
+{
+  public:
+    /**
+     * @brief Construct a new Shiftable Range Map object where the whole range of K
+     *        is associated with value 'defaultVal'.
+     */
+    ShiftableRangeMap( V const& defaultVal )
+    : mDefaultVal { defaultVal }
+    {}
+
+
+
+    /**
+     * @brief Associate 'keyVal' to range ['keyBegin', 'keyEnd'[, overwriting any previous
+     *        values which overlap with this range. Ranges where 'keyEnd' is not greater
+     *        than 'keyBegin' are ignored. The runtime for this call is expected O(log N)
+     *        plus freeing the overwritten ranges.
+     *
+     * @param keyBegin  The start of the range.
+     * @param keyEnd    The end of the range. Note that the range excludes 'keyEnd'.
+     * @param keyVal    The value to associate to the range ['keyBegin', 'keyEnd'[
+     */
+    void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key' in expected O(log N)
+     *
+     * @param key  The key to lookup
+     * @return     The value associated with 'key'
+     */
+    V const& operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Opens a gap of 'delta' keys at 'from': every range boundary at or after 'from'
+     *        moves up by 'delta'. The keys of the gap take the value of the range before
+     *        'from', like text typed at the end of a styled span. The runtime for this call
+     *        is expected O(log N).
+     *
+     * @param from   The first key of the gap.
+     * @param delta  The size of the gap, must not be negative.
+     */
+    void shift( K const& from, K const& delta );
+
+
+
+    /**
+     * @brief Cuts the keys ['keyBegin', 'keyEnd'[ out of the key space: their ranges are
+     *        removed and every range boundary after them moves down by 'keyEnd' - 'keyBegin'.
+     *        The ranges on both sides of the span become neighbours, and are merged when they
+     *        hold the same value. Spans where 'keyEnd' is not greater than 'keyBegin' are
+     *        ignored. The runtime for this call is expected O(log N) plus freeing the removed
+     *        ranges.
+     *
+     * @param keyBegin  The start of the span.
+     * @param keyEnd    The end of the span, which is excluded from the span.
+     */
+    void remove_span( K const& keyBegin, K const& keyEnd );
+
+
+
+    /**
+     * @brief Returns the number of stored range boundaries.
+     */
+    std::size_t size() const;
+
+
+
+    /**
+     * @brief Calls 'fn(key, value)' for every stored range boundary, in key order.
+     */
+    template<typename F>
+    void for_each( F&& fn ) const;
+
+
+
+    /**
+     * @brief Returns the stored range boundaries as a 'std::map', in the layout used
+     *        by 'RangeMap::data()'. The runtime is O(N).
+     */
+    std::map<K,V> to_map() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the nodes of the tree. The runtime is O(N).
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+  private:
+    struct Node;
+    using NodePtr = std::unique_ptr<Node>;
+
+    struct Node
+    {
+        K             key;
+        V             value;
+        std::uint64_t priority; // Heap order of the treap, a parent has a higher priority than its children
+        K             offset;   // Added to the keys of this node and its whole subtree, not applied yet
+        std::size_t   count;    // Number of nodes in the subtree
+        NodePtr       left;
+        NodePtr       right;
+    };
+
+
+    static NodePtr MakeLeaf( K const& key, V const& value );
+
+
+    /**
+     * @brief Applies the pending offset of 'node' to its key and hands it down to its children.
+     */
+    static void PushOffset( Node& node );
+
+
+    /**
+     * @brief Recomputes the subtree count of 'node' from its children.
+     */
+    static void Update( Node& node );
+
+
+    /**
+     * @brief Splits 'tree' into the nodes with keys less than 'key' and the nodes with
+     *        keys greater than or equal to 'key'.
+     */
+    static std::pair<NodePtr, NodePtr> Split( NodePtr tree, K const& key );
+
+
+    /**
+     * @brief Joins two trees, where all keys in 'lhs' are less than all keys in 'rhs'.
+     */
+    static NodePtr Join( NodePtr lhs, NodePtr rhs );
+
+
+    /**
+     * @brief Returns 'tree' without its first node.
+     */
+    static NodePtr RemoveFirst( NodePtr tree );
+
+
+    /**
+     * @brief Return the first and last node of 'tree', with the offsets on the path to them
+     *        applied, so their keys are up to date.
+     */
+    static Node* First( NodePtr const& tree );
+    static Node* Last ( NodePtr const& tree );
+
+
+    template<typename F>
+    static void ForEach( Node const* node, K const& offset, F& fn );
+
+
+    static std::size_t Count( NodePtr const& tree );
+
+
+    // Member variables
+    V       mDefaultVal; // Default value for values of 'K' that fall outside ranges
+    NodePtr mRoot;       // Root of the treap storing the ranges, empty if there are no ranges
+};
+
+
+
+
+template<typename K, typename V>
+void ShiftableRangeMap<K,V>::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    // ignore invalid range
+    if( !(keyBegin < keyEnd) )
+    {
+        return;
+    }
+
+    // Cut the tree into the part before, inside and after the new range, like 'PersistentRangeMap::assign()'
+    auto [lhs, rest] = Split( std::move(mRoot), keyBegin );
+    auto [mid, rhs]  = Split( std::move(rest),  keyEnd   );
+
+    Node const* lhsLast  { Last(lhs) };
+    Node const* midLast  { Last(mid) };
+    Node const* rhsFirst { First(rhs) };
+
+    V const& valueBeforeBegin { lhsLast ? lhsLast->value : mDefaultVal };
+    V const& valueAtEnd       { midLast ? midLast->value : valueBeforeBegin };
+
+    NodePtr seam;
+
+    // insert 'keyBegin', unless the previous range is extended
+    if( !(valueBeforeBegin == keyVal) )
+    {
+        seam = MakeLeaf( keyBegin, keyVal );
+    }
+
+    // insert 'keyEnd', continuing the range the new range was placed on top of
+    const bool isRangeStartingAtKeyEnd { rhsFirst && !(keyEnd < rhsFirst->key) };
+    if( isRangeStartingAtKeyEnd )
+    {
+        if( rhsFirst->value == keyVal )
+        {
+            rhs = RemoveFirst( std::move(rhs) ); // new range is extended by the range after it
+        }
+    }
+    else if( !(valueAtEnd == keyVal) )
+    {
+        seam = Join( std::move(seam), MakeLeaf( keyEnd, valueAtEnd ) );
+    }
+
+    mRoot = Join( Join( std::move(lhs), std::move(seam) ), std::move(rhs) );
+}
+
+
+
+template<typename K, typename V>
+V const& ShiftableRangeMap<K,V>::operator[]( K const& key ) const
+{
+    // find the last node with a key less than or equal to 'key', adding up the offsets on the way
+    Node const* found  { nullptr };
+    Node const* node   { mRoot.get() };
+    K           offset {};
+
+    while( node )
+    {
+        offset = K( offset + node->offset );
+
+        if( key < K( node->key + offset ) )
+        {
+            node = node->left.get();
+        }
+        else
+        {
+            found = node;
+            node  = node->right.get();
+        }
+    }
+
+    return found ? found->value : mDefaultVal;
+}
+
+
+
+template<typename K, typename V>
+void ShiftableRangeMap<K,V>::shift( K const& from, K const& delta )
+{
+    auto [lhs, rhs] = Split( std::move(mRoot), from );
+
+    if( rhs )
+    {
+        rhs->offset = K( rhs->offset + delta );
+    }
+
+    mRoot = Join( std::move(lhs), std::move(rhs) );
+}
+
+
+
+template<typename K, typename V>
+void ShiftableRangeMap<K,V>::remove_span( K const& keyBegin, K const& keyEnd )
+{
+    // ignore invalid span
+    if( !(keyBegin < keyEnd) )
+    {
+        return;
+    }
+
+    // Cut the tree into the part before, inside and after the span:
+    //
+    //          keyBegin      keyEnd
+    //              |           |
+    //              ▼           ▼
+    // [  'a'  'b'   |  'c'  'd' |  'e'  's'  ]
+    //  \_________/   \_______/   \________/
+    //     lhs         removed        rhs
+    //
+    auto [lhs, rest]    = Split( std::move(mRoot), keyBegin );
+    auto [removed, rhs] = Split( std::move(rest),  keyEnd   );
+
+    Node const* lhsLast     { Last(lhs) };
+    Node const* removedLast { Last(removed) };
+
+    V const& valueBeforeBegin { lhsLast     ? lhsLast->value     : mDefaultVal };
+    V const& valueAtEnd       { removedLast ? removedLast->value : valueBeforeBegin };
+
+    // move the ranges after the span down, so 'keyEnd' lands on 'keyBegin'
+    if( rhs )
+    {
+        rhs->offset = K( rhs->offset - K( keyEnd - keyBegin ) );
+    }
+
+    NodePtr seam;
+
+    Node const* rhsFirst { First(rhs) };
+    const bool isRangeStartingAtKeyBegin { rhsFirst && !(keyBegin < rhsFirst->key) };
+    if( isRangeStartingAtKeyBegin )
+    {
+        if( rhsFirst->value == valueBeforeBegin )
+        {
+            rhs = RemoveFirst( std::move(rhs) ); // the ranges on both sides of the span merge
+        }
+    }
+    else if( !(valueAtEnd == valueBeforeBegin) )
+    {
+        seam = MakeLeaf( keyBegin, valueAtEnd ); // the range the span ended in continues at 'keyBegin'
+    }
+
+    mRoot = Join( Join( std::move(lhs), std::move(seam) ), std::move(rhs) );
+}
+
+
+
+template<typename K, typename V>
+std::size_t ShiftableRangeMap<K,V>::size() const
+{
+    return Count( mRoot );
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void ShiftableRangeMap<K,V>::for_each( F&& fn ) const
+{
+    ForEach( mRoot.get(), K{}, fn );
+}
+
+
+
+template<typename K, typename V>
+std::map<K,V> ShiftableRangeMap<K,V>::to_map() const
+{
+    std::map<K,V> out;
+
+    for_each( [&out]( K const& key, V const& value ){ out.emplace_hint( out.end(), key, value ); } );
+
+    return out;
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage ShiftableRangeMap<K,V>::memory_usage() const
+{
+    RangeMapMemoryUsage usage;
+    usage.boundaries = size();
+    usage.nodeBytes  = size() * (sizeof(Node) - sizeof(K) - sizeof(V));
+
+    for_each( [&usage]( K const& key, V const& value )
+    {
+        usage.keyBytes   += ObjectBytes( key );
+        usage.valueBytes += ObjectBytes( value );
+    });
+
+    return usage;
+}
+
+
+
+template<typename K, typename V>
+typename ShiftableRangeMap<K,V>::NodePtr ShiftableRangeMap<K,V>::MakeLeaf( K const& key, V const& value )
+{
+    thread_local std::mt19937_64 generator { std::random_device{}() };
+
+    return std::make_unique<Node>( Node { key, value, generator(), K{}, 1, nullptr, nullptr } );
+}
+
+
+
+template<typename K, typename V>
+void ShiftableRangeMap<K,V>::PushOffset( Node& node )
+{
+    node.key = K( node.key + node.offset );
+
+    if( node.left )
+    {
+        node.left->offset = K( node.left->offset + node.offset );
+    }
+
+    if( node.right )
+    {
+        node.right->offset = K( node.right->offset + node.offset );
+    }
+
+    node.offset = K{};
+}
+
+
+
+template<typename K, typename V>
+void ShiftableRangeMap<K,V>::Update( Node& node )
+{
+    node.count = 1 + Count( node.left ) + Count( node.right );
+}
+
+
+
+template<typename K, typename V>
+std::pair<typename ShiftableRangeMap<K,V>::NodePtr, typename ShiftableRangeMap<K,V>::NodePtr>
+ShiftableRangeMap<K,V>::Split( NodePtr tree, K const& key )
+{
+    if( !tree )
+    {
+        return { nullptr, nullptr };
+    }
+
+    PushOffset( *tree );
+
+    if( tree->key < key )
+    {
+        auto [lhs, rhs] = Split( std::move(tree->right), key );
+        tree->right = std::move(lhs);
+        Update( *tree );
+        return { std::move(tree), std::move(rhs) };
+    }
+    else
+    {
+        auto [lhs, rhs] = Split( std::move(tree->left), key );
+        tree->left = std::move(rhs);
+        Update( *tree );
+        return { std::move(lhs), std::move(tree) };
+    }
+}
+
+
+
+template<typename K, typename V>
+typename ShiftableRangeMap<K,V>::NodePtr ShiftableRangeMap<K,V>::Join( NodePtr lhs, NodePtr rhs )
+{
+    if( !lhs ) { return rhs; }
+    if( !rhs ) { return lhs; }
+
+    // the offset of the new parent must not apply to the subtree joined below it
+    if( rhs->priority < lhs->priority )
+    {
+        PushOffset( *lhs );
+        lhs->right = Join( std::move(lhs->right), std::move(rhs) );
+        Update( *lhs );
+        return lhs;
+    }
+    else
+    {
+        PushOffset( *rhs );
+        rhs->left = Join( std::move(lhs), std::move(rhs->left) );
+        Update( *rhs );
+        return rhs;
+    }
+}
+
+
+
+template<typename K, typename V>
+typename ShiftableRangeMap<K,V>::NodePtr ShiftableRangeMap<K,V>::RemoveFirst( NodePtr tree )
+{
+    PushOffset( *tree );
+
+    if( !tree->left )
+    {
+        return std::move(tree->right);
+    }
+
+    tree->left = RemoveFirst( std::move(tree->left) );
+    Update( *tree );
+    return tree;
+}
+
+
+
+template<typename K, typename V>
+typename ShiftableRangeMap<K,V>::Node* ShiftableRangeMap<K,V>::First( NodePtr const& tree )
+{
+    Node* node { tree.get() };
+
+    while( node )
+    {
+        PushOffset( *node );
+        if( !node->left )
+        {
+            break;
+        }
+        node = node->left.get();
+    }
+
+    return node;
+}
+
+
+
+template<typename K, typename V>
+typename ShiftableRangeMap<K,V>::Node* ShiftableRangeMap<K,V>::Last( NodePtr const& tree )
+{
+    Node* node { tree.get() };
+
+    while( node )
+    {
+        PushOffset( *node );
+        if( !node->right )
+        {
+            break;
+        }
+        node = node->right.get();
+    }
+
+    return node;
+}
+
+
+
+template<typename K, typename V>
+template<typename F>
+void ShiftableRangeMap<K,V>::ForEach( Node const* node, K const& offset, F& fn )
+{
+    if( !node )
+    {
+        return;
+    }
+
+    const K nodeOffset { K( offset + node->offset ) };
+
+    ForEach( node->left.get(), nodeOffset, fn );
+    fn( K( node->key + nodeOffset ), node->value );
+    ForEach( node->right.get(), nodeOffset, fn );
+}
+
+
+
+template<typename K, typename V>
+std::size_t ShiftableRangeMap<K,V>::Count( NodePtr const& tree )
+{
+    return tree ? tree->count : 0;
+}
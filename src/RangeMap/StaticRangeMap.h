@@ -0,0 +1,216 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/FlatRangeAssign.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A range ['keyBegin', 'keyEnd'[ associated with 'value', as passed to 'make_static_range_map()'.
+ */
+template<typename K, typename V>
+struct StaticRange
+{
+    K keyBegin;
+    K keyEnd;
+    V value;
+};
+
+
+
+/**
+ * @brief The definition of a StaticRangeMap: its default value and the ranges assigned to it in
+ *        order, as returned by the function passed to 'make_static_range_map()'.
+ */
+template<typename K, typename V>
+struct StaticRanges
+{
+    V                             defaultVal;
+    std::vector<StaticRange<K,V>> ranges;
+};
+
+
+
+/**
+ * @brief A read-only range map with room for up to 'N' range boundaries, stored in two sorted
+ *        arrays without any heap memory. It is meant to be built at compile time by
+ *        'make_static_range_map()', so static tables like character classes or protocol code
+ *        ranges need no initialization at startup and live in read-only memory.
+ *
+ *        Lookups do a binary search where every step selects the next position with a
+ *        conditional move instead of a branch, so their runtime does not depend on how well
+ *        the searched keys can be predicted.
+ *
+ * @tparam K  The key type, must be default constructible, copyable and less-than comparable via operator<
+ * @tparam V  The value type, must be default constructible, copyable and equality-comparable via operator==
+ * @tparam N  The maximum number of range boundaries
+ */
+template<typename K, typename V, std::size_t N>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_default_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_default_constructible<V>::value &&
+                  is_equality_comparable<V>
+class StaticRangeMap
+{
+  public:
+    /**
+     * @brief Construct a new Static Range Map object from the range boundaries 'boundaries',
+     *        laid out like 'RangeMap::data()'. Boundaries beyond the capacity 'N' are dropped.
+     *
+     * @param defaultVal  The value of the keys before the first boundary.
+     * @param boundaries  Range boundaries sorted by key, each range lasts until the next boundary.
+     */
+    constexpr StaticRangeMap( V const& defaultVal, std::span<std::pair<K,V> const> boundaries )
+    {
+        mSize = std::min( boundaries.size(), N );
+
+        mValues[0] = defaultVal;
+        for( std::size_t index{0}; index < mSize; ++index )
+        {
+            mKeys  [index]     = boundaries[index].first;
+            mValues[index + 1] = boundaries[index].second;
+        }
+    }
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key'. The runtime is O(log N)
+     *        without data dependent branches.
+     *
+     * @param key  The key to lookup
+     * @return     The value associated with 'key'
+     */
+    constexpr V const& operator[]( K const& key ) const
+    {
+        // narrow down to the last boundary not greater than 'key', or the first boundary if there is none
+        K const*    base   { mKeys.data() };
+        std::size_t length { mSize };
+
+        while( length > 1 )
+        {
+            const std::size_t half { length / 2 };
+            base    = (key < base[half]) ? base : base + half;
+            length -= half;
+        }
+
+        // 'mValues' is shifted by one, so that index 0, for keys before the first boundary, holds the default
+        const std::size_t count { std::size_t( base - mKeys.data() ) + (mSize > 0 && !(key < *base) ? 1 : 0) };
+
+        return mValues[count];
+    }
+
+
+
+    /**
+     * @brief Returns the number of stored range boundaries.
+     */
+    constexpr std::size_t size() const
+    {
+        return mSize;
+    }
+
+
+
+    /**
+     * @brief Calls 'fn(key, value)' for every stored range boundary, in key order.
+     */
+    template<typename F>
+    constexpr void for_each( F&& fn ) const
+    {
+        for( std::size_t index{0}; index < mSize; ++index )
+        {
+            fn( mKeys[index], mValues[index + 1] );
+        }
+    }
+
+
+
+    /**
+     * @brief Returns the memory used by the stored range boundaries, with the unused capacity
+     *        of the arrays as 'nodeBytes'. Maps built by 'make_static_range_map()' have none.
+     */
+    RangeMapMemoryUsage memory_usage() const
+    {
+        RangeMapMemoryUsage usage;
+        usage.boundaries = mSize;
+        usage.nodeBytes  = (N - mSize) * (sizeof(K) + sizeof(V));
+
+        for_each( [&usage]( K const& key, V const& value )
+        {
+            usage.keyBytes   += ObjectBytes( key );
+            usage.valueBytes += ObjectBytes( value );
+        });
+
+        return usage;
+    }
+
+
+
+  private:
+    // Member variables
+    std::array<K, N>     mKeys   {};     // Range boundaries, sorted
+    std::array<V, N + 1> mValues {};     // The default value, followed by the value of each boundary
+    std::size_t          mSize   { 0 };  // Number of stored range boundaries
+};
+
+
+
+/**
+ * @brief Returns the range boundaries of 'definition', laid out like 'RangeMap::data()'.
+ */
+template<typename K, typename V>
+consteval std::vector<std::pair<K,V>> StaticBoundaries( StaticRanges<K,V> const& definition )
+{
+    std::vector<std::pair<K,V>> boundaries;
+
+    for( StaticRange<K,V> const& range : definition.ranges )
+    {
+        if( range.keyBegin < range.keyEnd )
+        {
+            FlatRangeAssign( boundaries, definition.defaultVal, range.keyBegin, range.keyEnd, range.value );
+        }
+    }
+
+    return boundaries;
+}
+
+
+
+/**
+ * @brief Builds a StaticRangeMap at compile time by assigning the ranges returned by 'definition()'
+ *        in order to a range map with their default value, so later ranges overwrite earlier ones
+ *        where they overlap. Ranges where 'keyEnd' is not greater than 'keyBegin' are ignored.
+ *
+ *        The definition is evaluated twice, once to count the boundaries and once to store them,
+ *        so the result has room for exactly as many boundaries as it holds. 'definition' must
+ *        therefore be a lambda without captures:
+ *
+ *        constexpr auto table = make_static_range_map( []{
+ *            return StaticRanges<char32_t, Class>{ Class::Other, {
+ *                { U'0', U'9' + 1, Class::Digit  },
+ *                { U'a', U'z' + 1, Class::Letter },
+ *            } };
+ *        } );
+ */
+template<typename F>
+    requires std::is_default_constructible<F>::value
+consteval auto make_static_range_map( F definition )
+{
+    constexpr std::size_t N { StaticBoundaries( F{}() ).size() };
+
+    auto const ranges     { definition() };
+    auto const boundaries { StaticBoundaries( ranges ) };
+
+    using Boundary = typename decltype(boundaries)::value_type;
+    return StaticRangeMap<typename Boundary::first_type, typename Boundary::second_type, N>( ranges.defaultVal, boundaries );
+}
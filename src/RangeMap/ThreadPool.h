@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief A fixed set of worker threads that run batches of tasks, used to spread bulk
+ *        operations on range maps over several cores.
+ *
+ *        The tasks of a batch are dealt round-robin to one queue per worker. A worker takes
+ *        tasks from the back of its own queue, and when that is empty it steals from the
+ *        front of the other queues, so workers that finish early take over the remaining
+ *        tasks of slower ones. The thread that runs the batch works on it too.
+ */
+class ThreadPool
+{
+  public:
+    /**
+     * @brief Starts 'numThreads' worker threads, besides the threads that run batches.
+     */
+    explicit ThreadPool( unsigned numThreads = std::max( 1u, std::thread::hardware_concurrency() ) - 1 )
+    : mQueues( numThreads + 1 )
+    {
+        mWorkers.reserve( numThreads );
+        for( unsigned index{0}; index < numThreads; ++index )
+        {
+            mWorkers.emplace_back( [this, index]( std::stop_token stopToken ){ WorkerLoop( stopToken, index ); } );
+        }
+    }
+
+
+
+    /**
+     * @brief Stops the worker threads. Batches still running are finished first.
+     */
+    ~ThreadPool()
+    {
+        for( auto& worker : mWorkers )
+        {
+            worker.request_stop();
+        }
+
+        {
+            std::lock_guard lock { mMutex };
+            ++mGeneration;
+        }
+        mWake.notify_all();
+    }
+
+
+
+    ThreadPool( ThreadPool const& )            = delete;
+    ThreadPool& operator=( ThreadPool const& ) = delete;
+
+
+
+    /**
+     * @brief Returns the number of threads that work on a batch, including the one running it.
+     */
+    std::size_t concurrency() const
+    {
+        return mWorkers.size() + 1;
+    }
+
+
+
+    /**
+     * @brief Calls 'task(index)' for every index in [0, 'count'[, spread over the worker threads
+     *        and the calling thread, and returns when all calls have returned. If calls throw,
+     *        the first exception is rethrown here once the others have finished. Batches from
+     *        several threads run one after the other.
+     */
+    template<typename F>
+    void run( std::size_t count, F&& task );
+
+
+
+  private:
+    struct TaskQueue
+    {
+        std::mutex              mutex;
+        std::deque<std::size_t> indices;
+    };
+
+
+    /**
+     * @brief Takes a task of the current batch, from queue 'own' or stolen from another queue.
+     */
+    std::optional<std::size_t> TakeTask( std::size_t own );
+
+
+    /**
+     * @brief Runs tasks of the current batch from queue 'own' until no tasks are left to take.
+     */
+    void WorkOnBatch( std::size_t own );
+
+
+    /**
+     * @brief Body of worker thread 'index', works on each new batch until stop is requested.
+     */
+    void WorkerLoop( std::stop_token stopToken, unsigned index );
+
+
+    // Member variables
+    std::vector<TaskQueue>            mQueues;                 // One per worker, the last one is used by the thread running the batch
+    std::function<void(std::size_t)>  mTask;                   // Task of the current batch
+    std::size_t                       mRemaining  { 0 };       // Tasks of the current batch that have not returned yet
+    std::exception_ptr                mError;                  // First exception thrown by a task of the current batch
+    std::uint64_t                     mGeneration { 0 };       // Incremented for every batch, wakes up the workers
+
+    std::mutex                        mRunMutex;               // Serializes batches
+    std::mutex                        mMutex;                  // Protects the batch state above
+    std::condition_variable_any       mWake;                   // Signals a new batch to the workers
+    std::condition_variable           mDone;                   // Signals the end of a batch to the thread running it
+
+    std::vector<std::jthread>         mWorkers;                // Must be last, so they are stopped before the other members are destroyed
+};
+
+
+
+
+template<typename F>
+void ThreadPool::run( std::size_t count, F&& task )
+{
+    if( count == 0 )
+    {
+        return;
+    }
+
+    std::lock_guard runLock { mRunMutex };
+
+    {
+        std::lock_guard lock { mMutex };
+        mTask      = [&task]( std::size_t index ){ task( index ); };
+        mRemaining = count;
+        mError     = nullptr;
+    }
+
+    // deal the tasks in contiguous runs, so each queue covers neighboring indices
+    const std::size_t numQueues { mQueues.size() };
+    for( std::size_t queue{0}; queue < numQueues; ++queue )
+    {
+        std::lock_guard lock { mQueues[queue].mutex };
+        for( std::size_t index{ count * queue / numQueues }; index < count * (queue + 1) / numQueues; ++index )
+        {
+            mQueues[queue].indices.push_back( index );
+        }
+    }
+
+    {
+        std::lock_guard lock { mMutex };
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    WorkOnBatch( numQueues - 1 );
+
+    std::unique_lock lock { mMutex };
+    mDone.wait( lock, [this]{ return mRemaining == 0; } );
+
+    mTask = nullptr;
+    if( mError )
+    {
+        std::rethrow_exception( std::exchange( mError, nullptr ) );
+    }
+}
+
+
+
+inline std::optional<std::size_t> ThreadPool::TakeTask( std::size_t own )
+{
+    {
+        std::lock_guard lock { mQueues[own].mutex };
+        if( !mQueues[own].indices.empty() )
+        {
+            const std::size_t index { mQueues[own].indices.back() };
+            mQueues[own].indices.pop_back();
+            return index;
+        }
+    }
+
+    for( std::size_t offset{1}; offset < mQueues.size(); ++offset )
+    {
+        TaskQueue& victim { mQueues[(own + offset) % mQueues.size()] };
+
+        std::lock_guard lock { victim.mutex };
+        if( !victim.indices.empty() )
+        {
+            const std::size_t index { victim.indices.front() };
+            victim.indices.pop_front();
+            return index;
+        }
+    }
+
+    return std::nullopt;
+}
+
+
+
+inline void ThreadPool::WorkOnBatch( std::size_t own )
+{
+    // Tasks are queued before the batch is published and a batch only ends once all of its
+    // tasks have returned, so every task taken here belongs to the batch of 'mTask'
+    while( auto index = TakeTask( own ) )
+    {
+        std::exception_ptr error;
+        try
+        {
+            mTask( *index );
+        }
+        catch( ... )
+        {
+            error = std::current_exception();
+        }
+
+        std::lock_guard lock { mMutex };
+        if( error && !mError )
+        {
+            mError = error;
+        }
+        if( --mRemaining == 0 )
+        {
+            mDone.notify_one();
+        }
+    }
+}
+
+
+
+inline void ThreadPool::WorkerLoop( std::stop_token stopToken, unsigned index )
+{
+    std::uint64_t seen { 0 };
+
+    while( true )
+    {
+        {
+            std::unique_lock lock { mMutex };
+            mWake.wait( lock, stopToken, [this, &seen]{ return mGeneration != seen; } );
+            if( stopToken.stop_requested() )
+            {
+                return;
+            }
+            seen = mGeneration;
+        }
+
+        WorkOnBatch( index );
+    }
+}
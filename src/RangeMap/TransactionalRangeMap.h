@@ -0,0 +1,212 @@
+#pragma once
+
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/PersistentRangeMap.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+
+/**
+ * @brief A range map that is updated through transactions. The assignments of a transaction
+ *        are buffered and become visible to readers all at once when it is committed.
+ *
+ *        Every committed state is an immutable PersistentRangeMap that is published through an
+ *        atomic 'std::shared_ptr'. A commit applies the transaction to a copy of the latest state
+ *        and then swaps the pointer, so readers never wait for a transaction to be applied. They
+ *        can wait for the swap itself: the atomic 'std::shared_ptr' of libstdc++ is not lock-free,
+ *        and loading it takes a short internal lock that a concurrent store also takes.
+ *
+ *        Committing copies O(T log N) tree nodes, where T is the number of ranges left after
+ *        coalescing the transaction's assignments. Transactions committed from different threads
+ *        are applied one at a time, in commit order.
+ *
+ * @tparam K  The key type, must be copyable, assignable and less-than comparable via operator<
+ * @tparam V  The value type, must be copyable, assignable and equality-comparable via operator==
+ */
+template<typename K, typename V>
+    requires std::is_copy_assignable<K>::value &&
+             std::is_copy_constructible<K>::value &&
+                  is_less_than_comparable<K> &&
+
+             std::is_copy_assignable<V>::value &&
+             std::is_copy_constructible<V>::value &&
+                  is_equality_comparable<V>
+class TransactionalRangeMap
+{
+  public:
+    /**
+     * @brief A group of assignments that is published atomically by 'commit()'. Dropping a
+     *        transaction without committing it discards its assignments.
+     */
+    class Transaction
+    {
+      public:
+        /**
+         * @brief Buffers the assignment of 'keyVal' to range ['keyBegin', 'keyEnd'[. Later
+         *        assignments of the same transaction overwrite earlier ones where they overlap.
+         */
+        void assign( K const& keyBegin, K const& keyEnd, V const& keyVal );
+
+
+
+        /**
+         * @brief Publishes all buffered assignments at once and empties the transaction,
+         *        so that it can be reused.
+         */
+        void commit();
+
+
+
+      private:
+        friend class TransactionalRangeMap;
+
+        Transaction( TransactionalRangeMap& owner )
+        : mOwner { owner }
+        {}
+
+        // Member variables
+        TransactionalRangeMap&         mOwner;
+        RangeMap<K, std::optional<V>>  mPending { std::nullopt }; // Coalesced assignments, empty where untouched
+    };
+
+
+
+    /**
+     * @brief Construct a new Transactional Range Map object where the whole range of K
+     *        is associated with value 'defaultVal'.
+     */
+    TransactionalRangeMap( V const& defaultVal )
+    : mPublished { std::make_shared<const PersistentRangeMap<K,V>>( defaultVal ) }
+    {}
+
+
+
+    /**
+     * @brief Starts a new transaction on this container.
+     */
+    Transaction begin();
+
+
+
+    /**
+     * @brief Does a lookup of the value associated with 'key' in the latest committed state.
+     *        The value is returned by copy, since the state it was read from can be replaced
+     *        by a concurrent commit.
+     */
+    V operator[]( K const& key ) const;
+
+
+
+    /**
+     * @brief Returns the latest committed state in O(1). Use it to do several lookups that
+     *        must observe the same state.
+     */
+    PersistentRangeMap<K,V> snapshot() const;
+
+
+
+    /**
+     * @brief Returns the memory used by the latest committed state, see
+     *        'PersistentRangeMap::memory_usage()'. Uncommitted transactions are not counted.
+     */
+    RangeMapMemoryUsage memory_usage() const;
+
+
+
+  private:
+    /**
+     * @brief Applies the coalesced assignments in 'pending' to the latest committed state
+     *        and publishes the result.
+     */
+    void Commit( RangeMap<K, std::optional<V>>& pending );
+
+
+    // Member variables
+    std::atomic<std::shared_ptr<const PersistentRangeMap<K,V>>> mPublished;   // Latest committed state
+    std::mutex                                                  mCommitMutex; // Serializes commits
+};
+
+
+
+
+template<typename K, typename V>
+void TransactionalRangeMap<K,V>::Transaction::assign( K const& keyBegin, K const& keyEnd, V const& keyVal )
+{
+    mPending.assign( keyBegin, keyEnd, keyVal );
+}
+
+
+
+template<typename K, typename V>
+void TransactionalRangeMap<K,V>::Transaction::commit()
+{
+    mOwner.Commit( mPending );
+}
+
+
+
+template<typename K, typename V>
+typename TransactionalRangeMap<K,V>::Transaction TransactionalRangeMap<K,V>::begin()
+{
+    return Transaction { *this };
+}
+
+
+
+template<typename K, typename V>
+V TransactionalRangeMap<K,V>::operator[]( K const& key ) const
+{
+    return (*mPublished.load())[key];
+}
+
+
+
+template<typename K, typename V>
+PersistentRangeMap<K,V> TransactionalRangeMap<K,V>::snapshot() const
+{
+    return *mPublished.load();
+}
+
+
+
+template<typename K, typename V>
+RangeMapMemoryUsage TransactionalRangeMap<K,V>::memory_usage() const
+{
+    return mPublished.load()->memory_usage();
+}
+
+
+
+template<typename K, typename V>
+void TransactionalRangeMap<K,V>::Commit( RangeMap<K, std::optional<V>>& pending )
+{
+    auto& ranges = pending.data();
+
+    if( ranges.empty() )
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock { mCommitMutex };
+
+        PersistentRangeMap<K,V> next { *mPublished.load() };
+
+        // Each stored range ends where the next one begins. The last element always
+        // marks the end of an assigned range, since it holds the default (empty) value.
+        for( auto it = ranges.begin(); std::next(it) != ranges.end(); ++it )
+        {
+            if( it->second )
+            {
+                next.assign( it->first, std::next(it)->first, *it->second );
+            }
+        }
+
+        mPublished.store( std::make_shared<const PersistentRangeMap<K,V>>( std::move(next) ) );
+    }
+
+    ranges.clear();
+}
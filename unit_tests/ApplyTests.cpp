@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include <random>
+
+
+bool checkIsCanonical( const std::map<int, int>& map, const int defaultValue )
+{
+  const int* prevValue { &defaultValue };
+
+  for( auto const& [key, value] : map )
+  {
+    if( value == *prevValue ) { return false; }
+    prevValue = &value;
+  }
+
+  return true;
+}
+
+
+TEST(ApplyTests, SplitsOnlyAtRangeBoundaries)
+{
+  // [     1     2     0  ]
+  //    |            |      <--- increment
+  // [  1  2     3  1  0  ]
+  RangeMap<int, int> rMap {0};
+  rMap.assign( 5, 10, 1 );
+  rMap.assign( 10, 15, 2 );
+
+  rMap.apply( 2, 12, []( int& value ){ ++value; } );
+
+  ASSERT_EQ( rMap.data(), (std::map<int,int>{ {2,1}, {5,2}, {10,3}, {12,2}, {15,0} }) );
+}
+
+
+TEST(ApplyTests, MergesRangesThatBecomeEqual)
+{
+  // [  1  2  3  0  ]
+  //       |     |    <--- decrement
+  // [  1     2  0  ]
+  RangeMap<int, int> rMap {0};
+  rMap.assign( 0, 5, 1 );
+  rMap.assign( 5, 10, 2 );
+  rMap.assign( 10, 15, 3 );
+
+  rMap.apply( 5, 15, []( int& value ){ --value; } );
+
+  ASSERT_EQ( rMap.data(), (std::map<int,int>{ {0,1}, {10,2}, {15,0} }) );
+}
+
+
+TEST(ApplyTests, AssignIfFillsOnlyDefaultGaps)
+{
+  RangeMap<int, int> rMap {0};
+  rMap.assign( 5, 10, 1 );
+  rMap.assign( 15, 20, 2 );
+
+  rMap.assign_if( 0, 30, []( int value ){ return value == 0; }, 7 );
+
+  ASSERT_EQ( rMap.data(), (std::map<int,int>{ {0,7}, {5,1}, {10,7}, {15,2}, {20,7}, {30,0} }) );
+}
+
+
+TEST(ApplyTests, InvalidRangeIsIgnored)
+{
+  RangeMap<int, int> rMap {0};
+  rMap.apply( 5, 5, []( int& value ){ ++value; } );
+  rMap.apply( 6, 5, []( int& value ){ ++value; } );
+
+  ASSERT_TRUE( rMap.data().empty() );
+}
+
+
+TEST(ApplyTests, RandomAgainstPerKeyModel)
+{
+  std::mt19937 gen(99);
+  std::uniform_int_distribution<> distKey(0, 180);
+  std::uniform_int_distribution<> distRsize(1, 20);
+  std::uniform_int_distribution<> distOp(0, 2);
+
+  RangeMap<int, int> rMap     {0};
+  RangeMap<int, int> follower {0};
+  std::array<int, 200> model {};
+  rMap.enable_change_log();
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const int lo { distKey(gen) };
+    const int hi { lo + distRsize(gen) };
+
+    switch( distOp(gen) )
+    {
+      case 0:
+        rMap.apply( lo, hi, []( int& value ){ value = (value + 1) % 3; } );
+        for( int k{lo}; k < hi; ++k ) { model[size_t(k)] = (model[size_t(k)] + 1) % 3; }
+        break;
+      case 1:
+        rMap.assign_if( lo, hi, []( int value ){ return value == 0; }, 2 );
+        for( int k{lo}; k < hi; ++k ) { if( model[size_t(k)] == 0 ) { model[size_t(k)] = 2; } }
+        break;
+      default:
+        rMap.assign( lo, hi, 1 );
+        for( int k{lo}; k < hi; ++k ) { model[size_t(k)] = 1; }
+        break;
+    }
+
+    ASSERT_TRUE( checkIsCanonical( rMap.data(), 0 ) ) << "\nnot canonical after operation " << n << "\n";
+    for( int k{0}; k < 200; ++k )
+    {
+      ASSERT_EQ( rMap[k], model[size_t(k)] ) << "\nmismatch at key " << k << " after operation " << n << "\n";
+    }
+
+    ASSERT_TRUE( follower.apply_delta( *rMap.changes_since( follower.version() ) ) );
+    ASSERT_EQ  ( follower.data(), rMap.data() );
+  }
+}
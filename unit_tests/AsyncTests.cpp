@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "RangeMap/AsyncRangeMap.h"
+#include <random>
+#include <vector>
+
+
+TEST(AsyncTests, FlushMakesAssignmentsVisible)
+{
+  AsyncRangeMap<int, char> rMap {' '};
+
+  rMap.assign(  0, 10, 'a' );
+  rMap.assign(  5, 15, 'b' );
+  rMap.assign( 12, 20, ' ' );
+  rMap.flush();
+
+  ASSERT_EQ( rMap[2],  'a' );
+  ASSERT_EQ( rMap[7],  'b' );
+  ASSERT_EQ( rMap[11], 'b' );
+  ASSERT_EQ( rMap[13], ' ' );
+}
+
+
+TEST(AsyncTests, SingleProducerMatchesSynchronousAssignment)
+{
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<> distKey(-1000, 1000);
+  std::uniform_int_distribution<> distVal(0, 5);
+  std::uniform_int_distribution<> distRsize(1, 100);
+
+  RangeMap<int, char>      expected {'g'};
+  AsyncRangeMap<int, char> rMap     {'g'};
+
+  for( size_t n{0}; n < 20'000; ++n )
+  {
+    const int  pos   { distKey(gen) };
+    const int  end   { pos + distRsize(gen) };
+    const char value ( char('a' + distVal(gen)) );
+
+    expected.assign( pos, end, value );
+    rMap.assign    ( pos, end, value );
+  }
+
+  rMap.flush();
+
+  for( int key{-1100}; key < 1200; ++key )
+  {
+    ASSERT_EQ( rMap[key], expected[key] ) << "\nmismatch at key " << key << "\n";
+  }
+}
+
+
+TEST(AsyncTests, ConcurrentProducersOnDisjointRanges)
+{
+  constexpr int numProducers { 4 };
+  constexpr int numAssigns   { 5'000 };
+
+  AsyncRangeMap<int, int> rMap {-1};
+
+  std::vector<std::thread> producers;
+  for( int p{0}; p < numProducers; ++p )
+  {
+    producers.emplace_back( [&rMap, p]()
+    {
+      // each producer owns keys [p*1000, p*1000+1000[ and ends by writing its id
+      for( int n{0}; n < numAssigns; ++n )
+      {
+        const int pos { p * 1000 + (n * 37) % 990 };
+        rMap.assign( pos, pos + 10, n );
+      }
+      rMap.assign( p * 1000, p * 1000 + 1000, p );
+      rMap.flush();
+
+      for( int key{p * 1000}; key < p * 1000 + 1000; ++key )
+      {
+        ASSERT_EQ( rMap[key], p );
+      }
+    });
+  }
+
+  for( auto& producer : producers )
+  {
+    producer.join();
+  }
+
+  ASSERT_EQ( rMap[-1],                  -1 );
+  ASSERT_EQ( rMap[numProducers * 1000], -1 );
+}
+
+
+TEST(AsyncTests, DestructionWithQueuedAssignmentsStopsApplier)
+{
+  for( int n{0}; n < 100; ++n )
+  {
+    AsyncRangeMap<int, int> rMap {0};
+    rMap.assign( 0, 10, n );
+  }
+}
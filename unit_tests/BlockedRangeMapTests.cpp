@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "RangeMap/BlockCodecs.h"
+#include <limits>
+#include <random>
+#include <string>
+
+
+std::string RandomShardKey( std::mt19937& gen )
+{
+  // long keys sharing prefixes, like the keys of a sharded key-value store
+  static const std::string prefixes[] { "tenant/0001/orders/", "tenant/0001/users/", "tenant/0002/orders/", "tenant/0017/" };
+  std::uniform_int_distribution<size_t> distPrefix( 0, std::size(prefixes) - 1 );
+  std::uniform_int_distribution<int>    distId( 0, 99'999 );
+
+  return prefixes[distPrefix(gen)] + std::to_string( distId(gen) );
+}
+
+
+TEST(BlockedRangeMapTests, FrontCodedRoundTrip)
+{
+  const std::vector<std::string> keys { "", "a", "ab", "abc", "abd", "b", "ba", "bab", "c" };
+
+  auto block = FrontCodedStringCodec::encode( keys.data(), keys.size() );
+
+  std::vector<std::string> decoded;
+  FrontCodedStringCodec::decode( keys.front(), block, decoded );
+  ASSERT_EQ( decoded, keys );
+}
+
+
+TEST(BlockedRangeMapTests, FrontCodedCountNotGreater)
+{
+  const std::vector<std::string> keys { "a", "ab", "abc", "abd", "abdz", "b", "ba", "bab", "c" };
+  const std::vector<std::string> queries { "a", "aa", "ab", "abb", "abc", "abca", "abd", "abdy", "abdz", "abz", "az",
+                                           "b", "b\x01", "ba", "baa", "bab", "babz", "bb", "c", "cc", "\xff" };
+
+  auto block = FrontCodedStringCodec::encode( keys.data(), keys.size() );
+
+  for( auto const& query : queries )
+  {
+    const auto expected { size_t( std::upper_bound( keys.begin(), keys.end(), query ) - keys.begin() ) };
+    ASSERT_EQ( FrontCodedStringCodec::count_not_greater( keys.front(), block, query ), expected ) << "\nquery: " << query << "\n";
+  }
+}
+
+
+TEST(BlockedRangeMapTests, InvalidRangeIsIgnored)
+{
+  StringRangeMap<int> rMap {0};
+  rMap.assign( "b", "a", 1 );
+  rMap.assign( "b", "b", 1 );
+
+  ASSERT_EQ( rMap.size(), 0u );
+  ASSERT_EQ( rMap["b"], 0 );
+}
+
+
+TEST(BlockedRangeMapTests, RandomStringKeysMatchRangeMap)
+{
+  std::mt19937 gen(2024);
+  std::uniform_int_distribution<int> distVal( 0, 4 );
+
+  RangeMap<std::string, int> expected {-1};
+  StringRangeMap<int, 8>     rMap     {-1};
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    auto keyBegin { RandomShardKey(gen) };
+    auto keyEnd   { RandomShardKey(gen) };
+    if( keyEnd < keyBegin )
+    {
+      std::swap( keyBegin, keyEnd );
+    }
+    const int value { distVal(gen) };
+
+    expected.assign( keyBegin, keyEnd, value );
+    rMap.assign    ( keyBegin, keyEnd, value );
+
+    if( n % 50 == 0 )
+    {
+      ASSERT_EQ( rMap.to_map(), (std::map<std::string,int>( expected.data().begin(), expected.data().end() )) ) << "\nmismatch after assignment " << n << "\n";
+    }
+  }
+
+  ASSERT_EQ( rMap.size(), expected.data().size() );
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const auto key { RandomShardKey(gen) };
+    ASSERT_EQ( rMap[key], expected[key] ) << "\nmismatch at key " << key << "\n";
+  }
+
+  // also look up the stored boundaries themselves
+  for( auto const& [key, value] : expected.data() )
+  {
+    ASSERT_EQ( rMap[key], value );
+  }
+}
+
+
+TEST(BlockedRangeMapTests, DeltaBitPackedRoundTrip)
+{
+  using Codec = DeltaBitPackedCodec<std::int64_t>;
+
+  const std::vector<std::vector<std::int64_t>> blocks {
+    { 7 },
+    { 1, 2, 3, 4, 5 },
+    { -100, -3, 0, 1, 1'000, 1'000'000'007 },
+    { std::numeric_limits<std::int64_t>::min(), 0, std::numeric_limits<std::int64_t>::max() },
+  };
+
+  for( auto const& keys : blocks )
+  {
+    auto block = Codec::encode( keys.data(), keys.size() );
+
+    std::vector<std::int64_t> decoded;
+    Codec::decode( keys.front(), block, decoded );
+    ASSERT_EQ( decoded, keys );
+
+    for( auto key{keys.front()}; key < keys.front() + 2'000 && key < keys.back(); ++key )
+    {
+      const auto expected { size_t( std::upper_bound( keys.begin(), keys.end(), key ) - keys.begin() ) };
+      ASSERT_EQ( Codec::count_not_greater( keys.front(), block, key ), expected ) << "\nkey: " << key << "\n";
+    }
+    ASSERT_EQ( Codec::count_not_greater( keys.front(), block, keys.back() ), keys.size() );
+  }
+}
+
+
+TEST(BlockedRangeMapTests, RandomIntegerKeysMatchRangeMap)
+{
+  std::mt19937_64 gen(2025);
+  std::uniform_int_distribution<std::uint64_t> distKey( 0, 1'000'000'000 );
+  std::uniform_int_distribution<std::uint64_t> distLen( 1, 10'000 );
+  std::uniform_int_distribution<int>           distVal( 0, 4 );
+
+  RangeMap<std::uint64_t, int>        expected {-1};
+  CompactRangeMap<std::uint64_t, int> rMap     {-1};
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const auto keyBegin { distKey(gen) };
+    const auto keyEnd   { keyBegin + distLen(gen) };
+    const int  value    { distVal(gen) };
+
+    expected.assign( keyBegin, keyEnd, value );
+    rMap.assign    ( keyBegin, keyEnd, value );
+  }
+
+  ASSERT_EQ( rMap.to_map(), (std::map<std::uint64_t,int>( expected.data().begin(), expected.data().end() )) );
+
+  for( auto const& [key, value] : expected.data() )
+  {
+    ASSERT_EQ( rMap[key],     value );
+    ASSERT_EQ( rMap[key - 1], expected[key - 1] );
+  }
+
+  // the keys take a few bytes per boundary instead of a tree node each
+  ASSERT_LT( rMap.memory_usage().keyBytes + rMap.memory_usage().nodeBytes,
+             (expected.memory_usage().keyBytes + expected.memory_usage().nodeBytes) / 5 );
+}
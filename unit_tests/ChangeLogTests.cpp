@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include <random>
+
+
+using Change = RangeMapChange<int, char>;
+
+
+TEST(ChangeLogTests, RecordsNetBoundaryEdits)
+{
+  RangeMap<int, char> rMap {' '};
+  rMap.assign( 5, 10, 'a' );
+
+  rMap.enable_change_log();
+
+  // [     a     s     ]
+  //          |     |     <--- insert 'b'
+  // [     a  b     s  ]
+  rMap.assign( 8, 12, 'b' );
+
+  auto delta = rMap.changes_since( 1 );
+  ASSERT_TRUE( delta.has_value() );
+  ASSERT_EQ( delta->fromVersion, 1u );
+  ASSERT_EQ( delta->toVersion,   2u );
+  ASSERT_EQ( delta->changes.size(), 3u );
+
+  EXPECT_EQ( delta->changes[0].kind, Change::Kind::Added   );
+  EXPECT_EQ( delta->changes[0].key,  8                     );
+  EXPECT_EQ( delta->changes[0].value, 'b'                  );
+  EXPECT_EQ( delta->changes[1].kind, Change::Kind::Removed );
+  EXPECT_EQ( delta->changes[1].key,  10                    );
+  EXPECT_EQ( delta->changes[2].kind, Change::Kind::Added   );
+  EXPECT_EQ( delta->changes[2].key,  12                    );
+  EXPECT_EQ( delta->changes[2].value, ' '                  );
+}
+
+
+TEST(ChangeLogTests, NoChangesForAssignmentOfSameValue)
+{
+  RangeMap<int, char> rMap {' '};
+  rMap.enable_change_log();
+
+  rMap.assign( 5, 10, 'a' );
+  rMap.assign( 6,  8, 'a' );
+
+  auto delta = rMap.changes_since( 1 );
+  ASSERT_TRUE( delta.has_value() );
+  ASSERT_TRUE( delta->changes.empty() );
+  ASSERT_EQ( delta->toVersion, 2u );
+}
+
+
+TEST(ChangeLogTests, ChangesSinceUnavailableVersion)
+{
+  RangeMap<int, char> rMap {' '};
+  ASSERT_FALSE( rMap.changes_since( 0 ).has_value() ); // log not enabled
+
+  rMap.assign( 1, 3, 'a' );
+  rMap.enable_change_log();
+  rMap.assign( 2, 4, 'b' );
+  rMap.assign( 3, 5, 'c' );
+
+  ASSERT_FALSE( rMap.changes_since( 0 ).has_value() ); // before log was enabled
+  ASSERT_TRUE ( rMap.changes_since( 1 ).has_value() );
+  ASSERT_FALSE( rMap.changes_since( 4 ).has_value() ); // newer than container
+
+  rMap.trim_change_log( 2 );
+  ASSERT_FALSE( rMap.changes_since( 1 ).has_value() );
+  ASSERT_TRUE ( rMap.changes_since( 2 ).has_value() );
+  ASSERT_EQ   ( rMap.changes_since( 2 )->changes.front().version, 3u );
+}
+
+
+TEST(ChangeLogTests, ApplyDeltaRejectsGaps)
+{
+  RangeMap<int, char> leader   {' '};
+  RangeMap<int, char> follower {' '};
+  leader.enable_change_log();
+
+  leader.assign( 1, 3, 'a' );
+  leader.assign( 2, 4, 'b' );
+
+  auto delta = leader.changes_since( 1 );
+  ASSERT_FALSE( follower.apply_delta( *delta ) );
+  ASSERT_TRUE ( follower.data().empty() );
+
+  ASSERT_TRUE ( follower.apply_delta( *leader.changes_since( 0 ) ) );
+  ASSERT_EQ   ( follower.version(), 2u );
+  ASSERT_EQ   ( follower.data(), leader.data() );
+
+  // re-applying an overlapping delta is idempotent
+  ASSERT_TRUE ( follower.apply_delta( *delta ) );
+  ASSERT_EQ   ( follower.data(), leader.data() );
+}
+
+
+TEST(ChangeLogTests, RandomFollowerStaysInSync)
+{
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<> distKey(-1000, 1000);
+  std::uniform_int_distribution<> distVal(0, 5);
+  std::uniform_int_distribution<> distRsize(1, 100);
+
+  RangeMap<int, char> leader   {'g'};
+  RangeMap<int, char> follower {'g'};
+  leader.enable_change_log();
+
+  for( size_t n{0}; n < 10'000; ++n )
+  {
+    const int pos { distKey(gen) };
+    leader.assign( pos, pos + distRsize(gen), char('a' + distVal(gen)) );
+
+    if( n % 7 == 0 )
+    {
+      auto delta = leader.changes_since( follower.version() );
+      ASSERT_TRUE( delta.has_value() );
+      ASSERT_TRUE( follower.apply_delta( *delta ) );
+      ASSERT_EQ  ( follower.data(), leader.data() ) << "\nout of sync after assignment " << n << "\n";
+
+      leader.trim_change_log( follower.version() );
+    }
+  }
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include "RangeMap/Classify.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+RangeMap<int, char> MakeRandomMap( unsigned seed, size_t assignments )
+{
+  std::mt19937 gen { seed };
+  std::uniform_int_distribution<> distKey(-100'000, 100'000);
+  std::uniform_int_distribution<> distVal(0, 5);
+  std::uniform_int_distribution<> distRsize(1, 1'000);
+
+  RangeMap<int, char> rMap {'g'};
+  for( size_t n{0}; n < assignments; ++n )
+  {
+    const int pos { distKey(gen) };
+    rMap.assign( pos, pos + distRsize(gen), char('a' + distVal(gen)) );
+  }
+  return rMap;
+}
+
+
+TEST(ClassifyTests, MatchesLookupsForSortedAndUnsortedKeys)
+{
+  const RangeMap<int, char> rMap { MakeRandomMap( 1, 2'000 ) };
+
+  std::mt19937 gen { 2 };
+  std::uniform_int_distribution<> distKey(-110'000, 110'000);
+
+  std::vector<int> keys( 100'000 );
+  for( auto& key : keys ) { key = distKey(gen); }
+
+  std::vector<int> sorted { keys };
+  std::sort( sorted.begin(), sorted.end() );
+
+  for( unsigned numThreads : { 0u, 1u, 3u } )
+  {
+    ThreadPool pool { numThreads };
+
+    for( auto const* input : { &keys, &sorted } )
+    {
+      std::vector<char> out( input->size() );
+      classify( rMap, *input, out, pool );
+
+      for( size_t index{0}; index < input->size(); ++index )
+      {
+        ASSERT_EQ( out[index], rMap[(*input)[index]] ) << "\nmismatch at key " << (*input)[index] << " with " << numThreads << " threads\n";
+      }
+    }
+  }
+}
+
+
+TEST(ClassifyTests, SingleThreadedAndEdgeCases)
+{
+  // empty map
+  const RangeMap<int, char> empty {'-'};
+  std::vector<int>  keys { 5, -3, 7, 7, 0 };
+  std::vector<char> out( keys.size() );
+  classify( empty, keys, out );
+  ASSERT_EQ( out, (std::vector<char>{ '-', '-', '-', '-', '-' }) );
+
+  // keys at boundaries, before the first and after the last
+  RangeMap<int, char> rMap {'-'};
+  rMap.assign( 0, 10, 'a' );
+  rMap.assign( 10, 20, 'b' );
+  keys = { -5, 0, 9, 10, 19, 20, 100, 100, 10 };
+  out.assign( keys.size(), ' ' );
+  classify( rMap, keys, out );
+  ASSERT_EQ( out, (std::vector<char>{ '-', 'a', 'a', 'b', 'b', '-', '-', '-', 'b' }) );
+
+  // no keys
+  ThreadPool pool { 2 };
+  classify( rMap, std::span<int const>{}, std::span<char>{}, pool );
+}
+
+
+TEST(ClassifyTests, StringKeysWithCustomComparator)
+{
+  RangeMap<std::string, int, std::greater<>> rMap {0};
+  rMap.assign( "m", "c", 1 ); // descending order
+  rMap.assign( "x", "p", 2 );
+
+  std::vector<std::string> keys { "z", "x", "q", "p", "n", "m", "d", "c", "a" };
+  std::vector<int>         out( keys.size() );
+
+  ThreadPool pool { 2 };
+  classify( rMap, keys, out, pool );
+
+  for( size_t index{0}; index < keys.size(); ++index )
+  {
+    ASSERT_EQ( out[index], rMap[keys[index]] ) << "\nmismatch at key " << keys[index] << "\n";
+  }
+}
+
+
+TEST(ClassifyTests, ThreadPoolRunsEveryTaskOnce)
+{
+  ThreadPool pool { 3 };
+  ASSERT_EQ( pool.concurrency(), 4u );
+
+  for( size_t count : { 1u, 7u, 1'000u } )
+  {
+    std::vector<std::atomic<int>> calls( count );
+    pool.run( count, [&calls]( size_t index ) { ++calls[index]; } );
+
+    for( auto const& call : calls )
+    {
+      ASSERT_EQ( call.load(), 1 );
+    }
+  }
+}
+
+
+TEST(ClassifyTests, ThreadPoolRethrowsTaskExceptions)
+{
+  ThreadPool pool { 2 };
+
+  std::atomic<int> calls { 0 };
+  auto task = [&calls]( size_t index )
+  {
+    ++calls;
+    if( index == 5 ) { throw std::runtime_error( "task failed" ); }
+  };
+  ASSERT_THROW( pool.run( 10, task ), std::runtime_error );
+  ASSERT_EQ( calls.load(), 10 ); // the other tasks still ran
+
+  // the pool is usable afterwards
+  calls = 0;
+  pool.run( 4, [&calls]( size_t ) { ++calls; } );
+  ASSERT_EQ( calls.load(), 4 );
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include <string>
+#include <string_view>
+#include <cstdlib>
+
+
+// Key type that counts how often it is constructed
+class CountedKey
+{
+public:
+  explicit CountedKey( int var ) : mVar { var } { ++sConstructions; }
+  CountedKey( CountedKey const& other ) : mVar { other.mVar } { ++sConstructions; }
+  CountedKey& operator=( CountedKey const& ) = default;
+
+  int value() const { return mVar; }
+
+  static inline int sConstructions { 0 };
+
+private:
+  int mVar;
+};
+
+
+struct CountedKeyLess
+{
+  using is_transparent = void;
+
+  bool operator()( CountedKey const& lhs, CountedKey const& rhs ) const { return lhs.value() < rhs.value(); }
+  bool operator()( CountedKey const& lhs, int rhs )               const { return lhs.value() < rhs; }
+  bool operator()( int lhs, CountedKey const& rhs )               const { return lhs < rhs.value(); }
+  bool operator()( int lhs, int rhs )                             const { return lhs < rhs; }
+};
+
+
+TEST(ComparatorTests, ReversedKeyOrder)
+{
+  RangeMap<int, char, std::greater<int>> rMap {' '};
+
+  // ranges run from high to low keys
+  rMap.assign( 10, 5, 'a' );
+  rMap.assign(  7, 2, 'b' );
+
+  ASSERT_EQ( rMap[11], ' ' );
+  ASSERT_EQ( rMap[10], 'a' );
+  ASSERT_EQ( rMap[8],  'a' );
+  ASSERT_EQ( rMap[7],  'b' );
+  ASSERT_EQ( rMap[3],  'b' );
+  ASSERT_EQ( rMap[2],  ' ' );
+  ASSERT_EQ( rMap.data(), (std::map<int, char, std::greater<int>>{ {10,'a'}, {7,'b'}, {2,' '} }) );
+
+  rMap.assign( 5, 10, 'c' ); // invalid in this order
+  ASSERT_EQ( rMap.data().size(), 3u );
+}
+
+
+TEST(ComparatorTests, StringKeysWithStringViewLookup)
+{
+  RangeMap<std::string, int, std::less<>> rMap {0};
+
+  rMap.assign( std::string_view{"apple"}, std::string_view{"banana"}, 1 );
+  rMap.assign( std::string{"cherry"},     std::string{"date"},        2 );
+
+  ASSERT_EQ( rMap[std::string_view{"apricot"}], 1 );
+  ASSERT_EQ( rMap[std::string_view{"banana"}],  0 );
+  ASSERT_EQ( rMap["coconut"],                   2 );
+  ASSERT_EQ( rMap[std::string{"aa"}],           0 );
+}
+
+
+TEST(ComparatorTests, HeterogeneousLookupConstructsNoKey)
+{
+  RangeMap<CountedKey, char, CountedKeyLess> rMap {' '};
+  rMap.assign( 10, 20, 'a' );
+  rMap.assign( 30, 40, 'b' );
+
+  const int constructionsBefore { CountedKey::sConstructions };
+
+  ASSERT_EQ( rMap[15], 'a' );
+  ASSERT_EQ( rMap[25], ' ' );
+  ASSERT_EQ( rMap[35], 'b' );
+
+  rMap.assign( 12, 18, 'a' ); // already holds 'a', nothing is stored
+
+  ASSERT_EQ( CountedKey::sConstructions, constructionsBefore );
+}
+
+
+TEST(ComparatorTests, StatefulComparator)
+{
+  auto byAbsoluteValue = []( int lhs, int rhs ){ return std::abs(lhs) < std::abs(rhs); };
+
+  RangeMap<int, char, decltype(byAbsoluteValue)> rMap { ' ', byAbsoluteValue };
+  rMap.assign( 2, -5, 'a' );
+
+  ASSERT_EQ( rMap[-3], 'a' );
+  ASSERT_EQ( rMap[ 4], 'a' );
+  ASSERT_EQ( rMap[-5], ' ' );
+}
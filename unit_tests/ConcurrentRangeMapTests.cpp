@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include "RangeMap/ConcurrentRangeMap.h"
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+TEST(ConcurrentRangeMapTests, SingleThreadMatchesRangeMap)
+{
+  std::mt19937 gen(41);
+  std::uniform_int_distribution<> distKey(-1000, 1000);
+  std::uniform_int_distribution<> distVal(0, 5);
+
+  RangeMap<int, char>           expected {'g'};
+  ConcurrentRangeMap<int, char> rMap     {'g'};
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const int  keyBegin { distKey(gen) };
+    const int  keyEnd   { distKey(gen) };
+    const char value    ( char('a' + distVal(gen)) );
+
+    expected.assign( keyBegin, keyEnd, value );
+    rMap.assign    ( keyBegin, keyEnd, value );
+  }
+
+  ASSERT_EQ( rMap.snapshot().to_map(), (std::map<int,char>( expected.data().begin(), expected.data().end() )) );
+}
+
+
+TEST(ConcurrentRangeMapTests, ConcurrentWritersLoseNoAssignments)
+{
+  // every writer owns a region of keys and keeps its own copy of the expected ranges
+  constexpr int numWriters { 8 };
+  constexpr int regionSize { 1'000 };
+
+  ConcurrentRangeMap<int, int>    rMap {-1};
+  std::vector<RangeMap<int, int>> expected( numWriters, RangeMap<int, int>{-1} );
+
+  std::vector<std::thread> writers;
+  for( int w{0}; w < numWriters; ++w )
+  {
+    writers.emplace_back( [&rMap, &expected, w]()
+    {
+      std::mt19937 gen { unsigned(w) };
+      std::uniform_int_distribution<> distKey( w * regionSize, (w + 1) * regionSize );
+      std::uniform_int_distribution<> distVal( 0, 3 );
+
+      for( size_t n{0}; n < 2'000; ++n )
+      {
+        int keyBegin { distKey(gen) };
+        int keyEnd   { distKey(gen) };
+        if( keyEnd < keyBegin ) { std::swap( keyBegin, keyEnd ); }
+        const int value { distVal(gen) };
+
+        rMap.assign               ( keyBegin, keyEnd, value );
+        expected[size_t(w)].assign( keyBegin, keyEnd, value );
+      }
+    });
+  }
+
+  for( auto& writer : writers ) { writer.join(); }
+
+  auto const snapshot { rMap.snapshot() };
+  for( int key{0}; key < numWriters * regionSize; ++key )
+  {
+    ASSERT_EQ( snapshot[key], expected[size_t(key / regionSize)][key] ) << "\nmismatch at key " << key << "\n";
+  }
+}
+
+
+TEST(ConcurrentRangeMapTests, ReadersNeverSeeTornAssignments)
+{
+  // writers only assign whole blocks of 'blockSize' keys over a small hot spot, so in every
+  // published version all keys of a block hold the same value
+  constexpr int numWriters { 6 };
+  constexpr int numReaders { 6 };
+  constexpr int blockSize  { 10 };
+  constexpr int numBlocks  { 20 };
+
+  ConcurrentRangeMap<int, int> rMap {0};
+  std::atomic<bool>            done { false };
+  std::atomic<int>             violations { 0 };
+
+  std::vector<std::thread> threads;
+  for( int w{0}; w < numWriters; ++w )
+  {
+    threads.emplace_back( [&rMap, w]()
+    {
+      std::mt19937 gen { unsigned(w) };
+      std::uniform_int_distribution<> distBlock( 0, numBlocks );
+      std::uniform_int_distribution<> distVal  ( 0, 3 );
+
+      for( size_t n{0}; n < 3'000; ++n )
+      {
+        const int blockBegin { distBlock(gen) };
+        const int blockEnd   { distBlock(gen) };
+        rMap.assign( blockBegin * blockSize, blockEnd * blockSize, distVal(gen) );
+      }
+    });
+  }
+
+  for( int r{0}; r < numReaders; ++r )
+  {
+    threads.emplace_back( [&rMap, &done, &violations]()
+    {
+      while( !done )
+      {
+        auto const snapshot { rMap.snapshot() };
+
+        int  previous  { 0 };
+        bool canonical { true };
+        snapshot.for_each( [&]( int key, int value )
+        {
+          canonical = canonical && key % blockSize == 0 && value != previous;
+          previous  = value;
+        });
+
+        if( !canonical )
+        {
+          ++violations;
+        }
+
+        // single lookups must agree with some published version
+        const int value { rMap[blockSize / 2] };
+        if( value < 0 || value > 3 )
+        {
+          ++violations;
+        }
+      }
+    });
+  }
+
+  for( int w{0}; w < numWriters; ++w ) { threads[size_t(w)].join(); }
+  done = true;
+  for( size_t t{numWriters}; t < threads.size(); ++t ) { threads[t].join(); }
+
+  ASSERT_EQ( violations, 0 );
+}
+
+
+TEST(ConcurrentRangeMapTests, StressMixedTrafficStaysCanonical)
+{
+  // all threads assign and look up blocks of 'blockSize' keys over the same hot spot, so
+  // they keep replacing each other's boundaries
+  constexpr int numThreads { 16 };
+  constexpr int blockSize  { 10 };
+  constexpr int numBlocks  { 50 };
+
+  ConcurrentRangeMap<int, int> rMap {0};
+  std::atomic<int>             violations { 0 };
+
+  std::vector<std::thread> threads;
+  for( int t{0}; t < numThreads; ++t )
+  {
+    threads.emplace_back( [&rMap, &violations, t]()
+    {
+      std::mt19937 gen { unsigned(t) + 100 };
+      std::uniform_int_distribution<> distBlock( 0, numBlocks );
+      std::uniform_int_distribution<> distVal  ( 0, 3 );
+      std::uniform_int_distribution<> distKey  ( -blockSize, (numBlocks + 1) * blockSize );
+      std::uniform_int_distribution<> distOp   ( 0, 99 );
+
+      for( size_t n{0}; n < 4'000; ++n )
+      {
+        const int op { distOp(gen) };
+        if( op < 40 )
+        {
+          rMap.assign( distBlock(gen) * blockSize, distBlock(gen) * blockSize, distVal(gen) );
+        }
+        else if( op < 99 )
+        {
+          const int value { rMap[distKey(gen)] };
+          if( value < 0 || value > 3 )
+          {
+            ++violations;
+          }
+        }
+        else
+        {
+          int previous { 0 };
+          rMap.snapshot().for_each( [&]( int key, int value )
+          {
+            if( key % blockSize != 0 || value == previous )
+            {
+              ++violations;
+            }
+            previous = value;
+          });
+        }
+      }
+    });
+  }
+
+  for( auto& thread : threads ) { thread.join(); }
+
+  ASSERT_EQ( violations, 0 );
+
+  // once the writers are done, lookups and the snapshot agree, and each block holds a single value
+  auto const snapshot { rMap.snapshot() };
+  for( int key{-blockSize}; key < (numBlocks + 1) * blockSize; ++key )
+  {
+    ASSERT_EQ( rMap[key], snapshot[key] ) << "\nmismatch at key " << key << "\n";
+    const int blockBegin { key - (key % blockSize + blockSize) % blockSize };
+    ASSERT_EQ( rMap[key], rMap[blockBegin] ) << "\nblock of key " << key << " is split\n";
+  }
+}
+
+
+// Counts its live instances, to check that removed boundaries are freed
+class CountedValue
+{
+public:
+  CountedValue( int var ) : mVar { var } { ++sLiveInstances; }
+  CountedValue( CountedValue const& other ) : mVar { other.mVar } { ++sLiveInstances; }
+  ~CountedValue() { --sLiveInstances; }
+
+  CountedValue& operator=( CountedValue const& ) = default;
+
+  friend bool operator==( CountedValue const& lhs, CountedValue const& rhs )
+  {
+    return lhs.mVar == rhs.mVar;
+  }
+
+  static inline std::atomic<int> sLiveInstances { 0 };
+
+private:
+  int mVar;
+};
+
+
+TEST(ConcurrentRangeMapTests, RemovedBoundariesAreFreed)
+{
+  {
+    ConcurrentRangeMap<int, CountedValue> rMap { CountedValue( -1 ) };
+
+    // without other threads, removed boundaries are freed a few batches after their removal
+    for( int n{0}; n < 50'000; ++n )
+    {
+      rMap.assign( n % 100, n % 100 + 10, CountedValue( n % 7 ) );
+    }
+    ASSERT_LT( CountedValue::sLiveInstances, 1'000 );
+
+    std::vector<std::thread> writers;
+    for( int w{0}; w < 4; ++w )
+    {
+      writers.emplace_back( [&rMap, w]()
+      {
+        for( int n{0}; n < 10'000; ++n )
+        {
+          rMap.assign( n % 100, n % 100 + 10, CountedValue( w * 1'000 + n % 7 ) );
+        }
+      });
+    }
+    for( auto& writer : writers ) { writer.join(); }
+  }
+
+  // the boundaries that were still waiting to be freed go with the container
+  ASSERT_EQ( CountedValue::sLiveInstances, 0 );
+}
@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/DiskRangeMap.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+
+// Path of a new, empty file in the temporary directory, removed again at the end of the test
+class TempFile
+{
+public:
+  TempFile( std::string const& name )
+  : mPath { std::filesystem::temp_directory_path() / ("DiskRangeMapTests_" + name + ".db") }
+  {
+    std::filesystem::remove( mPath );
+  }
+
+  ~TempFile() { std::filesystem::remove( mPath ); }
+
+  std::string path() const { return mPath.string(); }
+
+private:
+  std::filesystem::path mPath;
+};
+
+
+TEST(DiskRangeMapTests, MatchesRangeMapForRandomAssignments)
+{
+  TempFile file { "random" };
+
+  std::mt19937 gen(4321);
+  std::uniform_int_distribution<> distKey(-20'000, 20'000);
+  std::uniform_int_distribution<> distVal(0, 5);
+  std::uniform_int_distribution<> distRsize(1, 100);
+  std::uniform_int_distribution<> distLong(1, 5'000);
+
+  RangeMap<int, char>     expected {'g'};
+  DiskRangeMap<int, char> disk     { file.path(), 'g', 8 }; // far fewer pages than the tree needs
+
+  for( size_t n{0}; n < 20'000; ++n )
+  {
+    const int  pos   { distKey(gen) };
+    const int  end   { pos + (n % 50 == 0 ? distLong(gen) : distRsize(gen)) };
+    const char value ( char('a' + distVal(gen)) );
+
+    expected.assign( pos, end, value );
+    disk.assign    ( pos, end, value );
+
+    if( n % 997 == 0 )
+    {
+      ASSERT_EQ( disk.to_map(), expected.data() ) << "\nmismatch after assignment " << n << "\n";
+      disk.sync();
+    }
+  }
+
+  ASSERT_EQ( disk.to_map(), expected.data() );
+  ASSERT_EQ( disk.size(), expected.data().size() );
+
+  for( int key{-21'000}; key < 26'000; key += 7 )
+  {
+    ASSERT_EQ( disk[key], expected[key] ) << "\nmismatch at key " << key << "\n";
+  }
+
+  // overwriting everything leaves a single range
+  disk.assign( -100'000, 100'000, 'z' );
+  ASSERT_EQ( disk.to_map(), (std::map<int,char>{ {-100'000,'z'}, {100'000,'g'} }) );
+}
+
+
+// Key that only fits a few times in a page, so that the tree gets deep
+struct WideKey
+{
+  WideKey() = default;
+  WideKey( int val ) : value { val } {}
+
+  friend bool operator<( WideKey const& lhs, WideKey const& rhs ) { return lhs.value < rhs.value; }
+
+  int  value { 0 };
+  char padding[500] {};
+};
+
+
+TEST(DiskRangeMapTests, DeepTreeMatchesRangeMap)
+{
+  TempFile file { "deep" };
+
+  std::mt19937 gen(1234);
+  std::uniform_int_distribution<> distKey(0, 3'000);
+  std::uniform_int_distribution<> distVal(0, 3);
+  std::uniform_int_distribution<> distRsize(1, 10);
+  std::uniform_int_distribution<> distLong(1, 1'000);
+
+  RangeMap<int, char>         expected {'g'};
+  DiskRangeMap<WideKey, char> disk     { file.path(), 'g', 16 };
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const int  pos   { distKey(gen) };
+    const int  end   { pos + (n % 100 == 0 ? distLong(gen) : distRsize(gen)) };
+    const char value ( char('a' + distVal(gen)) );
+
+    expected.assign( pos, end, value );
+    disk.assign    ( pos, end, value );
+
+    if( n % 499 == 0 )
+    {
+      disk.sync();
+    }
+  }
+
+  std::map<int, char> stored;
+  disk.for_each( [&stored]( WideKey const& key, char value ) { stored.emplace( key.value, value ); } );
+  ASSERT_EQ( stored, expected.data() );
+
+  for( int key{-10}; key < 4'100; ++key )
+  {
+    ASSERT_EQ( disk[key], expected[key] ) << "\nmismatch at key " << key << "\n";
+  }
+}
+
+
+TEST(DiskRangeMapTests, ReopensAtTheLastSync)
+{
+  TempFile file { "reopen" };
+
+  {
+    DiskRangeMap<std::uint64_t, std::uint32_t> disk { file.path(), 0, 4 };
+
+    for( std::uint64_t key{0}; key < 5'000; ++key )
+    {
+      disk.assign( key * 10, key * 10 + 5, std::uint32_t(key % 7 + 1) );
+    }
+    disk.sync();
+
+    // lost, since it is not synced, although some pages are written when they are evicted
+    disk.assign( 1'000, 40'000, 9 );
+  }
+
+  DiskRangeMap<std::uint64_t, std::uint32_t> disk { file.path(), 42, 4 };
+
+  ASSERT_EQ( disk.size(), 10'000u );
+  ASSERT_EQ( disk[1'000],  std::uint32_t(100 % 7 + 1) );
+  ASSERT_EQ( disk[1'007],  0u ); // the default value is the one stored in the file
+  ASSERT_EQ( disk[49'994], std::uint32_t(4'999 % 7 + 1) );
+
+  disk.assign( 1'000, 40'000, 9 );
+  disk.sync();
+
+  const auto synced = disk.to_map();
+
+  DiskRangeMap<std::uint64_t, std::uint32_t> reopened { file.path(), 0 };
+  ASSERT_EQ( reopened.to_map(), synced );
+}
+
+
+TEST(DiskRangeMapTests, FallsBackToThePreviousCommitIfTheLastOneIsTorn)
+{
+  TempFile file { "torn" };
+
+  {
+    DiskRangeMap<int, char> disk { file.path(), '-' };
+    disk.assign( 0, 10, 'a' );
+    disk.sync(); // generation 1, superblock in page 1
+    disk.assign( 5, 20, 'b' );
+    disk.sync(); // generation 2, superblock in page 0
+  }
+
+  // tear the superblock of the last commit
+  {
+    std::fstream stream { file.path(), std::ios::in | std::ios::out | std::ios::binary };
+    stream.seekp( 40 );
+    stream.write( "torn", 4 );
+  }
+
+  DiskRangeMap<int, char> disk { file.path(), '-' };
+  ASSERT_EQ( disk.to_map(), (std::map<int,char>{ {0,'a'}, {10,'-'} }) );
+}
+
+
+TEST(DiskRangeMapTests, ReusesReplacedPagesAfterSync)
+{
+  TempFile file { "reuse" };
+
+  DiskRangeMap<int, int> disk { file.path(), 0, 16 };
+
+  for( int round{0}; round < 20; ++round )
+  {
+    for( int key{0}; key < 20'000; key += 2 )
+    {
+      disk.assign( key, key + 1, round + key % 3 );
+    }
+    disk.sync();
+  }
+
+  // one version of the tree needs about 40 pages, and each round replaces all of them
+  ASSERT_LT( std::filesystem::file_size( file.path() ), 300u * DiskPageFile::PageSize );
+}
+
+
+TEST(DiskRangeMapTests, RejectsFilesOfOtherTypes)
+{
+  TempFile file { "types" };
+
+  {
+    DiskRangeMap<int, char> disk { file.path(), '-' };
+    disk.assign( 0, 10, 'a' );
+    disk.sync();
+  }
+
+  using WideMap = DiskRangeMap<std::uint64_t, char>;
+  ASSERT_THROW( WideMap( file.path(), '-' ), std::runtime_error );
+}
+
+
+// Writes a tree of several pages to 'path', then overwrites all inner pages in the file with 'corrupt'
+template<typename F>
+void CorruptInnerPages( std::string const& path, F corrupt )
+{
+  {
+    DiskRangeMap<int, char> disk { path, '-' };
+    for( int key{0}; key < 20'000; key += 2 )
+    {
+      disk.assign( key, key + 1, 'a' );
+    }
+    disk.sync();
+  }
+
+  std::fstream stream { path, std::ios::in | std::ios::out | std::ios::binary };
+  const auto   numPages { std::filesystem::file_size( path ) / DiskPageFile::PageSize };
+
+  for( std::uintmax_t id{2}; id < numPages; ++id )
+  {
+    DiskPageFile::Page page;
+    stream.seekg( std::streamoff( id * DiskPageFile::PageSize ) );
+    stream.read( reinterpret_cast<char*>( page.data() ), std::streamsize( page.size() ) );
+
+    std::uint32_t isLeaf;
+    std::memcpy( &isLeaf, page.data(), sizeof(isLeaf) );
+    if( isLeaf == 0 )
+    {
+      corrupt( page );
+      stream.seekp( std::streamoff( id * DiskPageFile::PageSize ) );
+      stream.write( reinterpret_cast<char const*>( page.data() ), std::streamsize( page.size() ) );
+    }
+  }
+}
+
+
+TEST(DiskRangeMapTests, RejectsPagesWithTooManyEntries)
+{
+  TempFile file { "count" };
+
+  CorruptInnerPages( file.path(), []( DiskPageFile::Page& page )
+  {
+    const std::uint32_t count { 0xFFFFFFFF };
+    std::memcpy( page.data() + sizeof(std::uint32_t), &count, sizeof(count) );
+  });
+
+  using Map = DiskRangeMap<int, char>;
+  ASSERT_THROW( Map( file.path(), '-' ), std::runtime_error );
+}
+
+
+TEST(DiskRangeMapTests, RejectsChildrenOutsideOfTheFile)
+{
+  TempFile file { "children" };
+
+  // keep the header, so that only the keys and the child ids are garbage
+  CorruptInnerPages( file.path(), []( DiskPageFile::Page& page )
+  {
+    std::fill( page.begin() + 2 * sizeof(std::uint32_t), page.end(), std::byte{0xFF} );
+  });
+
+  using Map = DiskRangeMap<int, char>;
+  ASSERT_THROW( Map( file.path(), '-' ), std::runtime_error );
+}
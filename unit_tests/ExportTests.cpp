@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/BlockCodecs.h"
+#include <random>
+#include <vector>
+
+
+class ExportTest : public ::testing::Test
+{
+ protected:
+  void SetUp() override
+  {
+    // [  a    b    s    c    s  ]
+    //    0    5   10   20   30
+    rMap.assign(  0,  5, 'a' );
+    rMap.assign(  5, 10, 'b' );
+    rMap.assign( 20, 30, 'c' );
+  }
+
+  RangeMap<int, char> rMap {' '};
+};
+
+
+TEST_F(ExportTest, AllBoundaries)
+{
+  std::vector<int>  keys  ( rMap.data().size() );
+  std::vector<char> values( rMap.data().size() );
+
+  ASSERT_EQ( rMap.export_columns( std::span<int>{keys}, std::span<char>{values} ), 5u );
+  ASSERT_EQ( keys,   (std::vector<int> { 0, 5, 10, 20, 30 }) );
+  ASSERT_EQ( values, (std::vector<char>{ 'a', 'b', ' ', 'c', ' ' }) );
+}
+
+
+TEST_F(ExportTest, ClippedRanges)
+{
+  ASSERT_EQ( rMap.column_count( 3, 25 ), 4u );
+  ASSERT_EQ( rMap.column_count( 25, 3 ), 0u );
+  ASSERT_EQ( rMap.column_count( 5, 10 ), 1u );
+
+  std::vector<int>  keys   ( 4 );
+  std::vector<char> values ( 4 );
+  std::vector<int>  lengths( 4 );
+
+  ASSERT_EQ( rMap.export_columns( 3, 25, std::span<int>{keys}, std::span<char>{values} ), 4u );
+  ASSERT_EQ( rMap.export_lengths( 3, 25, std::span<int>{lengths} ), 4u );
+
+  ASSERT_EQ( keys,    (std::vector<int> { 3, 5, 10, 20 }) );
+  ASSERT_EQ( values,  (std::vector<char>{ 'a', 'b', ' ', 'c' }) );
+  ASSERT_EQ( lengths, (std::vector<int> { 2, 5, 10, 5 }) );
+}
+
+
+TEST_F(ExportTest, ValueIdsAndSmallBuffers)
+{
+  std::vector<int> keys( 2 );
+  std::vector<int> ids ( 2 );
+
+  auto toId = []( char value ){ return value == ' ' ? 0 : value - 'a' + 1; };
+
+  ASSERT_EQ( rMap.export_columns( 6, 40, std::span<int>{keys}, std::span<int>{ids}, toId ), 2u );
+  ASSERT_EQ( keys, (std::vector<int>{ 6, 10 }) );
+  ASSERT_EQ( ids,  (std::vector<int>{ 2, 0 }) );
+}
+
+
+TEST(ExportTests, BlockedRangeMapMatchesRangeMap)
+{
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<> distKey(0, 99'999);
+  std::uniform_int_distribution<> distVal(0, 9);
+
+  RangeMap<std::string, int> expected {-1};
+  StringRangeMap<int, 16>    blocked  {-1};
+
+  for( size_t n{0}; n < 2'000; ++n )
+  {
+    auto keyBegin { "key/" + std::to_string( distKey(gen) ) };
+    auto keyEnd   { "key/" + std::to_string( distKey(gen) ) };
+    const int value { distVal(gen) };
+
+    expected.assign( keyBegin, keyEnd, value );
+    blocked.assign ( keyBegin, keyEnd, value );
+  }
+
+  std::vector<std::string> expectedKeys  ( expected.data().size() ), keys  ( blocked.size() );
+  std::vector<int>         expectedValues( expected.data().size() ), values( blocked.size() );
+
+  ASSERT_EQ( expected.export_columns( std::span<std::string>{expectedKeys}, std::span<int>{expectedValues} ),
+             blocked.export_columns ( std::span<std::string>{keys},         std::span<int>{values} ) );
+  ASSERT_EQ( keys,   expectedKeys   );
+  ASSERT_EQ( values, expectedValues );
+}
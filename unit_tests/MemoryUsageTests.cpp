@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include "RangeMap/PersistentRangeMap.h"
+#include "RangeMap/BlockCodecs.h"
+#include "RangeMap/AsyncRangeMap.h"
+#include "RangeMap/ConcurrentRangeMap.h"
+#include "RangeMap/RangeMap2D.h"
+#include "RangeMap/RangeMultiMap.h"
+#include "RangeMap/ShiftableRangeMap.h"
+#include "RangeMap/StaticRangeMap.h"
+#include "RangeMap/TransactionalRangeMap.h"
+#include <random>
+#include <string>
+
+
+// A value owning 'size' bytes of heap memory, reported through the customization point
+struct Blob
+{
+  std::size_t size;
+
+  bool operator==( Blob const& ) const = default;
+};
+
+template<>
+struct RangeMapHeapBytes<Blob>
+{
+  std::size_t operator()( Blob const& blob ) const { return blob.size; }
+};
+
+
+TEST(MemoryUsageTests, EmptyMap)
+{
+  RangeMap<int, int> rMap {0};
+
+  auto usage { rMap.memory_usage() };
+
+  ASSERT_EQ( usage.boundaries, 0u );
+  ASSERT_EQ( usage.total(),    0u );
+}
+
+
+TEST(MemoryUsageTests, CountsNodesKeysAndValues)
+{
+  RangeMap<int, int> rMap {0};
+  rMap.assign(  0, 10, 1 );
+  rMap.assign( 20, 30, 2 );
+
+  auto usage { rMap.memory_usage() };
+
+  ASSERT_EQ( usage.boundaries, 4u );
+  ASSERT_EQ( usage.keyBytes,   4 * sizeof(int) );
+  ASSERT_EQ( usage.valueBytes, 4 * sizeof(int) );
+  ASSERT_EQ( usage.nodeBytes,  4 * (TreeNodeBytes<std::pair<const int, int>>() - 2 * sizeof(int)) );
+  ASSERT_EQ( usage.extraBytes, 0u );
+}
+
+
+TEST(MemoryUsageTests, CountsHeapMemoryOfValues)
+{
+  RangeMap<int, std::string> shortValues {""};
+  RangeMap<int, std::string> longValues  {""};
+  RangeMap<int, Blob>        blobs       {Blob{0}};
+
+  shortValues.assign( 0, 10, "a" );
+  longValues.assign ( 0, 10, std::string( 1000, 'a' ) );
+  blobs.assign      ( 0, 10, Blob{ 1000 } );
+
+  ASSERT_EQ( shortValues.memory_usage().valueBytes, 2 * sizeof(std::string) );
+  ASSERT_GE( longValues.memory_usage().valueBytes,  2 * sizeof(std::string) + 1001 );
+  ASSERT_EQ( blobs.memory_usage().valueBytes,       2 * sizeof(Blob) + 1000 );
+}
+
+
+TEST(MemoryUsageTests, ChangeLogAndValueIndexAreExtraBytes)
+{
+  RangeMap<int, int> rMap {0};
+  rMap.enable_change_log();
+  rMap.enable_value_index();
+  rMap.assign( 0, 10, 1 );
+
+  auto const usage { rMap.memory_usage() };
+  ASSERT_GT( usage.extraBytes, 0u );
+
+  rMap.disable_change_log();
+  rMap.disable_value_index();
+
+  ASSERT_EQ( rMap.memory_usage().extraBytes, 0u );
+  ASSERT_EQ( rMap.memory_usage().total(),    usage.total() - usage.extraBytes );
+}
+
+
+TEST(MemoryUsageTests, BackendsAgreeOnBoundaries)
+{
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<> distKey(0, 99'999);
+  std::uniform_int_distribution<> distVal(0, 9);
+
+  RangeMap<std::string, int>    rMap       {-1};
+  PersistentRangeMap<int, int>  persistent {-1};
+  RangeMap<int, int>            intMap     {-1};
+  StringRangeMap<int>           blocked    {-1};
+  AsyncRangeMap<int, int>       async      {-1};
+
+  for( size_t n{0}; n < 2'000; ++n )
+  {
+    const int keyBegin { distKey(gen) };
+    const int keyEnd   { distKey(gen) };
+    const int value    { distVal(gen) };
+
+    auto key = []( int k ){ return "/a/rather/long/common/prefix/" + std::to_string( k ); };
+
+    rMap.assign      ( key(keyBegin), key(keyEnd), value );
+    blocked.assign   ( key(keyBegin), key(keyEnd), value );
+    intMap.assign    ( keyBegin, keyEnd, value );
+    persistent.assign( keyBegin, keyEnd, value );
+    async.assign     ( keyBegin, keyEnd, value );
+  }
+  async.flush();
+
+  ASSERT_EQ( blocked.memory_usage().boundaries,    rMap.memory_usage().boundaries );
+  ASSERT_EQ( persistent.memory_usage().boundaries, intMap.memory_usage().boundaries );
+  ASSERT_EQ( persistent.memory_usage().keyBytes,   intMap.memory_usage().keyBytes );
+  ASSERT_EQ( persistent.memory_usage().valueBytes, intMap.memory_usage().valueBytes );
+  ASSERT_EQ( async.memory_usage().total(),         intMap.memory_usage().total() );
+
+  // front coding stores the shared prefixes once per block
+  ASSERT_LT( blocked.memory_usage().keyBytes, rMap.memory_usage().keyBytes / 2 );
+  ASSERT_LT( blocked.memory_usage().total(),  rMap.memory_usage().total() );
+}
+
+
+TEST(MemoryUsageTests, AllContainersAgreeOnBoundaries)
+{
+  std::mt19937 gen(6);
+  std::uniform_int_distribution<> distKey(0, 99'999);
+  std::uniform_int_distribution<> distVal(0, 9);
+
+  RangeMap<int, int>              rMap          {-1};
+  ShiftableRangeMap<int, int>     shiftable     {-1};
+  TransactionalRangeMap<int, int> transactional {-1};
+  ConcurrentRangeMap<int, int>    concurrent    {-1};
+
+  for( size_t n{0}; n < 2'000; ++n )
+  {
+    const int keyBegin { distKey(gen) };
+    const int keyEnd   { distKey(gen) };
+    const int value    { distVal(gen) };
+
+    rMap.assign      ( keyBegin, keyEnd, value );
+    shiftable.assign ( keyBegin, keyEnd, value );
+    concurrent.assign( keyBegin, keyEnd, value );
+
+    auto transaction { transactional.begin() };
+    transaction.assign( keyBegin, keyEnd, value );
+    transaction.commit();
+  }
+
+  const std::vector<std::pair<int, int>> boundaries { rMap.data().begin(), rMap.data().end() };
+  const StaticRangeMap<int, int, 2'000>  fixed { -1, boundaries };
+
+  auto expected { rMap.memory_usage() };
+  for( auto usage : { shiftable.memory_usage(), transactional.memory_usage(), concurrent.memory_usage(), fixed.memory_usage() } )
+  {
+    ASSERT_EQ( usage.boundaries, expected.boundaries );
+    ASSERT_EQ( usage.keyBytes,   expected.keyBytes );
+    ASSERT_EQ( usage.valueBytes, expected.valueBytes );
+    ASSERT_GT( usage.nodeBytes,  0u );
+  }
+
+  // the static map only has the unused capacity as overhead
+  ASSERT_EQ( fixed.memory_usage().nodeBytes, (2'000 - boundaries.size()) * 2 * sizeof(int) );
+}
+
+
+TEST(MemoryUsageTests, MultiMapCountsBothKeys)
+{
+  RangeMultiMap<int, std::string> rMap;
+  ASSERT_EQ( rMap.memory_usage().keyBytes, 0u );
+
+  rMap.insert( 0,  10, "a" );
+  rMap.insert( 5,  15, "b" );
+  rMap.insert( 20, 30, std::string( 100, 'c' ) );
+
+  auto usage { rMap.memory_usage() };
+  ASSERT_EQ( usage.boundaries, 3u );
+  ASSERT_EQ( usage.keyBytes,   6 * sizeof(int) );
+  ASSERT_GE( usage.valueBytes, 3 * sizeof(std::string) + 100 );
+  ASSERT_GT( usage.nodeBytes,  0u );
+}
+
+
+TEST(MemoryUsageTests, RangeMap2DCountsSharedNodesOnce)
+{
+  RangeMap2D<int, int, int> rMap {0};
+
+  // every range of the first dimension shares the inner ranges of the first rectangle
+  rMap.assign( { 0, 1'000, 0, 1'000 }, 1 );
+  for( int n{0}; n < 100; ++n )
+  {
+    rMap.assign( { n * 10, n * 10 + 5, 0, 1 }, 2 );
+  }
+
+  auto usage { rMap.memory_usage() };
+
+  std::size_t unsharedBoundaries { rMap.data().data().size() };
+  for( auto const& [key, inner] : rMap.data().data() )
+  {
+    unsharedBoundaries += inner.memory_usage().boundaries;
+  }
+
+  ASSERT_GT( usage.boundaries, rMap.data().data().size() );
+  ASSERT_LT( usage.boundaries, unsharedBoundaries );
+}
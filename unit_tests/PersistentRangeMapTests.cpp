@@ -0,0 +1,390 @@
+#include <gtest/gtest.h>
+#include "RangeMap/PersistentRangeMap.h"
+#include <random>
+
+
+// Value type that counts its live instances, to check that nodes are freed
+class CountedValue
+{
+public:
+  CountedValue( const char var ) : mVar { var } { ++sLiveInstances; }
+  CountedValue( CountedValue const& other ) : mVar { other.mVar } { ++sLiveInstances; }
+  ~CountedValue() { --sLiveInstances; }
+
+  CountedValue& operator=( CountedValue const& ) = default;
+
+  friend bool operator==( CountedValue const& lhs, CountedValue const& rhs )
+  {
+    return lhs.mVar == rhs.mVar;
+  }
+
+  static inline int sLiveInstances { 0 };
+
+private:
+  char mVar;
+};
+
+
+TEST(PersistentRangeMapTests, MatchesRangeMapForRandomAssignments)
+{
+  std::mt19937 gen(4321);
+  std::uniform_int_distribution<> distKey(-1000, 1000);
+  std::uniform_int_distribution<> distVal(0, 5);
+  std::uniform_int_distribution<> distRsize(1, 100);
+
+  RangeMap<int, char>           expected   {'g'};
+  PersistentRangeMap<int, char> persistent {'g'};
+
+  for( size_t n{0}; n < 20'000; ++n )
+  {
+    const int  pos   { distKey(gen) };
+    const int  end   { pos + distRsize(gen) };
+    const char value ( char('a' + distVal(gen)) );
+
+    expected.assign  ( pos, end, value );
+    persistent.assign( pos, end, value );
+
+    if( n % 97 == 0 )
+    {
+      ASSERT_EQ( persistent.to_map(), expected.data() ) << "\nmismatch after assignment " << n << "\n";
+    }
+  }
+
+  ASSERT_EQ( persistent.size(), expected.data().size() );
+
+  for( int key{-1100}; key < 1200; ++key )
+  {
+    ASSERT_EQ( persistent[key], expected[key] ) << "\nmismatch at key " << key << "\n";
+  }
+}
+
+
+TEST(PersistentRangeMapTests, SnapshotIsNotAffectedByLaterAssignments)
+{
+  PersistentRangeMap<int, char> rMap {' '};
+  rMap.assign( 5, 10, 'a' );
+
+  auto snapshot = rMap.snapshot();
+
+  rMap.assign( 0,  7, 'b' );
+  rMap.assign( 8, 20, ' ' );
+
+  ASSERT_EQ( snapshot.to_map(), (std::map<int,char>{ {5,'a'}, {10,' '} }) );
+  ASSERT_EQ( rMap.to_map(),     (std::map<int,char>{ {0,'b'}, {7,'a'}, {8,' '} }) );
+  ASSERT_EQ( snapshot[6], 'a' );
+  ASSERT_EQ( rMap[6],     'b' );
+}
+
+
+TEST(PersistentRangeMapTests, OldVersionsAreFreedWithLastSnapshot)
+{
+  {
+    PersistentRangeMap<int, CountedValue> rMap { ' ' };
+    for( int i{0}; i < 100; ++i )
+    {
+      rMap.assign( i * 10, i * 10 + 5, CountedValue( char('a' + i % 20) ) );
+    }
+
+    const int liveBeforeSnapshot { CountedValue::sLiveInstances };
+
+    {
+      auto snapshot = rMap.snapshot();
+      rMap.assign( 0, 1000, ' ' );
+
+      ASSERT_EQ( rMap.size(), 0u );
+      ASSERT_EQ( CountedValue::sLiveInstances, liveBeforeSnapshot + 1 ); // still owned by the snapshot (+ its default value)
+    }
+
+    ASSERT_EQ( CountedValue::sLiveInstances, 1 ); // only the default value is left
+  }
+
+  ASSERT_EQ( CountedValue::sLiveInstances, 0 );
+}
+
+
+TEST(PersistentRangeMapTests, EqualityComparesContent)
+{
+  PersistentRangeMap<int, char> lhs {' '};
+  PersistentRangeMap<int, char> rhs {' '};
+  ASSERT_TRUE( lhs == rhs );
+
+  lhs.assign( 0, 10, 'a' );
+  lhs.assign( 5, 15, 'b' );
+  ASSERT_FALSE( lhs == rhs );
+  ASSERT_TRUE ( lhs == lhs.snapshot() );
+
+  // same ranges built in another order, so the trees are not shared
+  rhs.assign( 5, 15, 'b' );
+  rhs.assign( 0,  5, 'a' );
+  ASSERT_TRUE( lhs == rhs );
+
+  rhs.assign( 14, 15, 'c' );
+  ASSERT_FALSE( lhs == rhs );
+  ASSERT_FALSE( (lhs == PersistentRangeMap<int, char>( '-' )) );
+}
+
+
+TEST(PersistentRangeMapTests, SameContentComparesHashes)
+{
+  PersistentRangeMap<int, char> lhs {' '};
+  PersistentRangeMap<int, char> rhs {' '};
+  ASSERT_TRUE( lhs.same_content( rhs ) );
+
+  lhs.assign( 0, 10, 'a' );
+  lhs.assign( 5, 15, 'b' );
+  ASSERT_FALSE( lhs.same_content( rhs ) );
+  ASSERT_TRUE ( lhs.same_content( lhs.snapshot() ) );
+
+  // same ranges built in another order, so the trees are not shared
+  rhs.assign( 5, 15, 'b' );
+  rhs.assign( 0,  5, 'a' );
+  ASSERT_TRUE( lhs.same_content( rhs ) );
+
+  rhs.assign( 14, 15, 'c' );
+  ASSERT_FALSE( lhs.same_content( rhs ) );
+  ASSERT_FALSE( (PersistentRangeMap<int, char>( ' ' ).same_content( PersistentRangeMap<int, char>( '-' ) )) );
+}
+
+
+using Spans = std::vector<std::pair<int,int>>;
+
+
+Spans DiffByScan( PersistentRangeMap<int, char> const& lhs, PersistentRangeMap<int, char> const& rhs, int keyBegin, int keyEnd )
+{
+  Spans out;
+  for( int key{keyBegin}; key < keyEnd; ++key )
+  {
+    if( lhs[key] != rhs[key] )
+    {
+      if( !out.empty() && out.back().second == key ) { ++out.back().second; }
+      else                                           { out.emplace_back( key, key + 1 ); }
+    }
+  }
+  return out;
+}
+
+
+TEST(PersistentRangeMapTests, ContentHashIgnoresAssignmentOrder)
+{
+  PersistentRangeMap<int, char> lhs {'-'};
+  PersistentRangeMap<int, char> rhs {'-'};
+
+  lhs.assign( 0, 20, 'a' );
+  lhs.assign( 5, 10, 'b' );
+
+  rhs.assign( 10, 20, 'a' );
+  rhs.assign(  5, 10, 'b' );
+  rhs.assign(  0,  5, 'a' );
+
+  ASSERT_EQ( lhs.content_hash(), rhs.content_hash() );
+  ASSERT_TRUE( lhs == rhs );
+
+  rhs.assign( 7, 8, 'c' );
+  ASSERT_NE( lhs.content_hash(), rhs.content_hash() );
+  const PersistentRangeMap<int, char> emptyMinus {'-'};
+  const PersistentRangeMap<int, char> emptyPlus  {'+'};
+  ASSERT_NE( lhs.content_hash(),       emptyMinus.content_hash() );
+  ASSERT_NE( emptyPlus.content_hash(), emptyMinus.content_hash() );
+}
+
+
+TEST(PersistentRangeMapTests, DiffReturnsDifferingSpans)
+{
+  // lhs: [ -  a  b  a  -     c  - ]
+  // rhs: [ -  a  b  a  -  d     - ]
+  //        0  5  10 20 30 40 45 50
+  PersistentRangeMap<int, char> lhs {'-'};
+  lhs.assign(  0, 30, 'a' );
+  lhs.assign(  5, 10, 'b' );
+  lhs.assign( 45, 50, 'c' );
+
+  PersistentRangeMap<int, char> rhs {'-'};
+  rhs.assign(  0, 30, 'a' );
+  rhs.assign(  5, 20, 'b' );
+  rhs.assign( 40, 45, 'd' );
+
+  ASSERT_EQ( lhs.diff( rhs ), (Spans{ {10, 20}, {40, 50} }) );
+  ASSERT_EQ( rhs.diff( lhs ), (Spans{ {10, 20}, {40, 50} }) );
+  ASSERT_TRUE( lhs.diff( lhs.snapshot() ).empty() );
+}
+
+
+TEST(PersistentRangeMapTests, DiffOfDivergedReplicasMatchesScan)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> distKey( 0, 20'000 );
+  std::uniform_int_distribution<> distLen( 1, 50 );
+  std::uniform_int_distribution<> distVal( 0, 5 );
+
+  PersistentRangeMap<int, char> base {'-'};
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const int keyBegin { distKey(gen) };
+    base.assign( keyBegin, keyBegin + distLen(gen), char('a' + distVal(gen)) );
+  }
+
+  for( size_t divergence : { 1u, 5u, 50u } )
+  {
+    auto lhs { base.snapshot() };
+    auto rhs { base.snapshot() };
+
+    for( size_t n{0}; n < divergence; ++n )
+    {
+      const int keyBegin { distKey(gen) };
+      auto& replica { n % 2 ? lhs : rhs };
+      replica.assign( keyBegin, keyBegin + distLen(gen), char('a' + distVal(gen)) );
+    }
+
+    ASSERT_EQ( lhs.diff( rhs ), DiffByScan( lhs, rhs, -10, 20'100 ) ) << "\ndivergence " << divergence << "\n";
+    ASSERT_EQ( lhs == rhs, lhs.diff( rhs ).empty() );
+  }
+}
+
+
+using CharMap = PersistentRangeMap<int, char>;
+
+
+TEST(PersistentRangeMapTests, SplitAndJoinFixTheSeam)
+{
+  // [ -  a  b  - ]
+  //   0  5  10 20
+  PersistentRangeMap<int, char> rMap {'-'};
+  rMap.assign(  5, 20, 'a' );
+  rMap.assign( 10, 20, 'b' );
+
+  auto [lhs, rhs] = rMap.split( 7 );
+  ASSERT_EQ( lhs.to_map(), (std::map<int,char>{ {5,'a'}, {7,'-'} }) );
+  ASSERT_EQ( rhs.to_map(), (std::map<int,char>{ {7,'a'}, {10,'b'}, {20,'-'} }) );
+  ASSERT_TRUE( CharMap::join( lhs, rhs ) == rMap );
+
+  // split at a boundary
+  auto [lhs10, rhs10] = rMap.split( 10 );
+  ASSERT_EQ( lhs10.to_map(), (std::map<int,char>{ {5,'a'}, {10,'-'} }) );
+  ASSERT_EQ( rhs10.to_map(), (std::map<int,char>{ {10,'b'}, {20,'-'} }) );
+  ASSERT_EQ( CharMap::join( lhs10, rhs10 ).to_map(), rMap.to_map() );
+
+  // split outside of all ranges
+  auto [lhs30, rhs30] = rMap.split( 30 );
+  ASSERT_TRUE( lhs30 == rMap );
+  ASSERT_EQ( rhs30.size(), 0u );
+
+  // joining with a gap keeps the gap
+  PersistentRangeMap<int, char> far {'-'};
+  far.assign( 40, 50, 'b' );
+  ASSERT_EQ( CharMap::join( rMap, far ).to_map(),
+             (std::map<int,char>{ {5,'a'}, {10,'b'}, {20,'-'}, {40,'b'}, {50,'-'} }) );
+}
+
+
+TEST(PersistentRangeMapTests, RandomSplitsJoinBackToTheOriginal)
+{
+  std::mt19937 gen(43);
+  std::uniform_int_distribution<> distKey( 0, 2'000 );
+  std::uniform_int_distribution<> distLen( 1, 100 );
+  std::uniform_int_distribution<> distVal( 0, 2 );
+
+  PersistentRangeMap<int, char> rMap {'-'};
+  for( size_t n{0}; n < 500; ++n )
+  {
+    const int keyBegin { distKey(gen) };
+    rMap.assign( keyBegin, keyBegin + distLen(gen), char('a' + distVal(gen)) );
+  }
+
+  for( size_t n{0}; n < 200; ++n )
+  {
+    const int key { distKey(gen) };
+    auto [lhs, rhs] = rMap.split( key );
+
+    for( int probe{key - 120}; probe < key + 120; ++probe )
+    {
+      ASSERT_EQ( lhs[probe], probe <  key ? rMap[probe] : '-' ) << "\nsplit at " << key << ", probe " << probe << "\n";
+      ASSERT_EQ( rhs[probe], probe >= key ? rMap[probe] : '-' ) << "\nsplit at " << key << ", probe " << probe << "\n";
+    }
+
+    ASSERT_EQ( CharMap::join( lhs, rhs ).to_map(), rMap.to_map() ) << "\nsplit at " << key << "\n";
+  }
+}
+
+
+TEST(PersistentRangeMapTests, TruncateBeforeCutsTheRangeOverTheWatermark)
+{
+  // [ -  a  b  - ]
+  //   0  5  10 20
+  PersistentRangeMap<int, char> rMap {'-'};
+  rMap.assign(  5, 20, 'a' );
+  rMap.assign( 10, 20, 'b' );
+
+  PersistentRangeMap<int, char> copy { rMap };
+
+  rMap.truncate_before( 7 );
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {7,'a'}, {10,'b'}, {20,'-'} }) );
+
+  rMap.truncate_before( 10 );
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {10,'b'}, {20,'-'} }) );
+
+  rMap.truncate_before( 20 );
+  ASSERT_EQ( rMap.size(), 0u );
+
+  // copies are not affected
+  ASSERT_EQ( copy.to_map(), (std::map<int,char>{ {5,'a'}, {10,'b'}, {20,'-'} }) );
+}
+
+
+TEST(PersistentRangeMapTests, TruncatedNodesAreFreedIncrementally)
+{
+  {
+    PersistentRangeMap<int, CountedValue> rMap { ' ' };
+
+    for( int i{0}; i < 1000; ++i )
+    {
+      rMap.assign( i * 10, i * 10 + 5, CountedValue( char('a' + i % 20) ) );
+    }
+
+    const int liveBeforeTruncation { CountedValue::sLiveInstances };
+
+    // dropping most of the ranges frees nothing right away ...
+    rMap.truncate_before( 9'000 );
+    const int liveAfterTruncation { CountedValue::sLiveInstances };
+    ASSERT_GT( liveAfterTruncation, liveBeforeTruncation / 2 );
+
+    // ... and every later assignment only frees a few of them
+    rMap.assign( 20'000, 20'005, CountedValue('x') );
+    ASSERT_GT( CountedValue::sLiveInstances, liveAfterTruncation - 100 );
+
+    ASSERT_TRUE( rMap.reclaim( 1'000'000 ) );
+    ASSERT_EQ( CountedValue::sLiveInstances, 1 + 2 * 100 + 2 ); // default value, kept ranges and the new range
+  }
+
+  ASSERT_EQ( CountedValue::sLiveInstances, 0 );
+}
+
+
+TEST(PersistentRangeMapTests, RetentionKeepsASlidingWindow)
+{
+  std::mt19937 gen(44);
+  std::uniform_int_distribution<> distLen( 1, 20 );
+  std::uniform_int_distribution<> distVal( 0, 2 );
+
+  const int window { 500 };
+
+  PersistentRangeMap<int, char> rMap {'-'};
+  PersistentRangeMap<int, char> full {'-'};
+  rMap.set_retention( window );
+
+  int time { 0 };
+  for( size_t n{0}; n < 2'000; ++n )
+  {
+    const int keyEnd { time + distLen(gen) };
+    const char value { char('a' + distVal(gen)) };
+    rMap.assign( time, keyEnd, value );
+    full.assign( time, keyEnd, value );
+    time = keyEnd;
+
+    const int watermark { time - window };
+    ASSERT_EQ( rMap[watermark - 1], '-' ) << "\nat time " << time << "\n";
+    ASSERT_EQ( rMap[watermark],     full[watermark] ) << "\nat time " << time << "\n";
+    ASSERT_EQ( rMap[time - 1],      full[time - 1] ) << "\nat time " << time << "\n";
+  }
+
+  ASSERT_LE( rMap.size(), size_t(window + 1) );
+}
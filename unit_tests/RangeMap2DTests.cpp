@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap2D.h"
+#include <random>
+
+
+TEST(RangeMap2DTests, RectangleAssignment)
+{
+  RangeMap2D<int, int, char> rMap {' '};
+  rMap.assign( { 10, 20, 100, 200 }, 'a' );
+
+  ASSERT_EQ( rMap( 10, 100 ), 'a' );
+  ASSERT_EQ( rMap( 19, 199 ), 'a' );
+  ASSERT_EQ( rMap(  9, 150 ), ' ' );
+  ASSERT_EQ( rMap( 20, 150 ), ' ' );
+  ASSERT_EQ( rMap( 15,  99 ), ' ' );
+  ASSERT_EQ( rMap( 15, 200 ), ' ' );
+}
+
+
+TEST(RangeMap2DTests, EmptyRectanglesAreIgnored)
+{
+  RangeMap2D<int, int, char> rMap {' '};
+  rMap.assign( { 10, 20, 100, 100 }, 'a' );
+  rMap.assign( { 20, 10, 100, 200 }, 'a' );
+
+  ASSERT_TRUE( rMap.data().data().empty() );
+}
+
+
+TEST(RangeMap2DTests, EqualNeighboursAreMerged)
+{
+  RangeMap2D<int, int, char> rMap {' '};
+  rMap.assign( { 10, 20, 100, 200 }, 'a' );
+  rMap.assign( { 20, 30, 100, 200 }, 'a' );
+
+  // one range of the first dimension, plus its end
+  ASSERT_EQ( rMap.data().data().size(), 2u );
+
+  // inner maps that become equal through other assignments do not share their trees
+  rMap.assign( { 30, 40, 150, 200 }, 'a' );
+  rMap.assign( { 30, 40, 100, 150 }, 'a' );
+  ASSERT_EQ( rMap.data().data().size(), 2u );
+
+  // overwriting with the default value removes everything again
+  rMap.assign( { 0, 50, 0, 300 }, ' ' );
+  ASSERT_TRUE( rMap.data().data().empty() );
+}
+
+
+TEST(RangeMap2DTests, RandomAgainstGrid)
+{
+  constexpr int size { 40 };
+
+  std::mt19937 gen(17);
+  std::uniform_int_distribution<> distKey(0, size - 1);
+  std::uniform_int_distribution<> distRsize(1, 15);
+  std::uniform_int_distribution<> distVal(0, 3);
+
+  RangeMap2D<int, int, char> rMap {'g'};
+  std::array<std::array<char, size>, size> grid;
+  for( auto& row : grid ) { row.fill('g'); }
+
+  for( size_t n{0}; n < 2'000; ++n )
+  {
+    const int  begin1 { distKey(gen) };
+    const int  end1   { std::min( size, begin1 + distRsize(gen) ) };
+    const int  begin2 { distKey(gen) };
+    const int  end2   { std::min( size, begin2 + distRsize(gen) ) };
+    const char value  ( char('a' + distVal(gen)) );
+
+    rMap.assign( { begin1, end1, begin2, end2 }, value );
+    for( int k1{begin1}; k1 < end1; ++k1 )
+    {
+      for( int k2{begin2}; k2 < end2; ++k2 )
+      {
+        grid[size_t(k1)][size_t(k2)] = value;
+      }
+    }
+
+    // neighbouring ranges of the first dimension never hold equal inner maps
+    auto const& outer = rMap.data().data();
+    for( auto it = outer.begin(); it != outer.end() && std::next(it) != outer.end(); ++it )
+    {
+      ASSERT_FALSE( it->second == std::next(it)->second ) << "\nnot canonical after assignment " << n << "\n";
+    }
+  }
+
+  for( int k1{0}; k1 < size; ++k1 )
+  {
+    for( int k2{0}; k2 < size; ++k2 )
+    {
+      ASSERT_EQ( rMap( k1, k2 ), grid[size_t(k1)][size_t(k2)] ) << "\nmismatch at (" << k1 << "," << k2 << ")\n";
+    }
+  }
+}
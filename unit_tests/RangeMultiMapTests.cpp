@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMultiMap.h"
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+
+using Handle = RangeMultiMap<int, char>::Handle;
+
+
+std::vector<Handle> Stab( RangeMultiMap<int, char> const& rMap, int key )
+{
+  std::vector<Handle> out;
+  rMap.stab( key, [&out]( Handle handle, int, int, char ){ out.push_back( handle ); } );
+  std::sort( out.begin(), out.end() );
+  return out;
+}
+
+
+std::vector<Handle> Overlap( RangeMultiMap<int, char> const& rMap, int keyBegin, int keyEnd )
+{
+  std::vector<Handle> out;
+  rMap.overlap( keyBegin, keyEnd, [&out]( Handle handle, int, int, char ){ out.push_back( handle ); } );
+  std::sort( out.begin(), out.end() );
+  return out;
+}
+
+
+TEST(RangeMultiMapTests, StabReturnsAllCoveringIntervals)
+{
+  RangeMultiMap<int, char> rMap;
+  const auto a = rMap.insert(  0, 10, 'a' );
+  const auto b = rMap.insert(  5, 15, 'b' );
+  const auto c = rMap.insert( 10, 20, 'c' );
+
+  ASSERT_EQ( Stab( rMap, -1 ), (std::vector<Handle>{}) );
+  ASSERT_EQ( Stab( rMap,  0 ), (std::vector<Handle>{ *a }) );
+  ASSERT_EQ( Stab( rMap,  7 ), (std::vector<Handle>{ *a, *b }) );
+  ASSERT_EQ( Stab( rMap, 10 ), (std::vector<Handle>{ *b, *c }) );
+  ASSERT_EQ( Stab( rMap, 20 ), (std::vector<Handle>{}) );
+
+  std::vector<char> values;
+  rMap.stab( 12, [&values]( Handle, int, int, char value ){ values.push_back( value ); } );
+  ASSERT_EQ( values, (std::vector<char>{ 'b', 'c' }) );
+}
+
+
+TEST(RangeMultiMapTests, EraseAndInvalidIntervals)
+{
+  RangeMultiMap<int, char> rMap;
+  ASSERT_FALSE( rMap.insert( 5, 5, 'x' ).has_value() );
+
+  const auto a = rMap.insert( 0, 10, 'a' );
+  const auto b = rMap.insert( 0, 10, 'b' ); // same interval twice
+  ASSERT_EQ( rMap.size(), 2u );
+
+  ASSERT_TRUE ( rMap.erase( *a ) );
+  ASSERT_FALSE( rMap.erase( *a ) );
+  ASSERT_EQ   ( Stab( rMap, 5 ), (std::vector<Handle>{ *b }) );
+  ASSERT_EQ   ( rMap.size(), 1u );
+}
+
+
+TEST(RangeMultiMapTests, RandomAgainstLinearScan)
+{
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<> distKey(0, 1000);
+  std::uniform_int_distribution<> distSize(1, 100);
+  std::uniform_int_distribution<> distOp(0, 3);
+
+  RangeMultiMap<int, char>                    rMap;
+  std::vector<std::tuple<Handle, int, int>>   intervals;
+
+  for( size_t n{0}; n < 3'000; ++n )
+  {
+    if( distOp(gen) == 0 && !intervals.empty() )
+    {
+      std::uniform_int_distribution<size_t> distIndex( 0, intervals.size() - 1 );
+      const size_t index { distIndex(gen) };
+      ASSERT_TRUE( rMap.erase( std::get<0>(intervals[index]) ) );
+      intervals.erase( intervals.begin() + std::ptrdiff_t(index) );
+    }
+    else
+    {
+      const int begin { distKey(gen) };
+      const int end   { begin + distSize(gen) };
+      intervals.emplace_back( *rMap.insert( begin, end, 'v' ), begin, end );
+    }
+
+    const int key { distKey(gen) };
+    const int end { key + distSize(gen) };
+
+    std::vector<Handle> expectedStab;
+    std::vector<Handle> expectedOverlap;
+    for( auto const& [handle, begin, finish] : intervals )
+    {
+      if( begin <= key && key < finish ) { expectedStab.push_back( handle );    }
+      if( begin <  end && key < finish ) { expectedOverlap.push_back( handle ); }
+    }
+    std::sort( expectedStab.begin(),    expectedStab.end()    );
+    std::sort( expectedOverlap.begin(), expectedOverlap.end() );
+
+    ASSERT_EQ( Stab( rMap, key ),         expectedStab    ) << "\nstab mismatch after operation " << n << "\n";
+    ASSERT_EQ( Overlap( rMap, key, end ), expectedOverlap ) << "\noverlap mismatch after operation " << n << "\n";
+  }
+
+  ASSERT_EQ( rMap.size(), intervals.size() );
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "RangeMap/ShiftableRangeMap.h"
+#include <random>
+#include <vector>
+
+
+// Reference model: the value of every key in [0, values.size()[, keys after it hold the default
+struct DenseModel
+{
+  char              defaultVal;
+  std::vector<char> values;
+
+  char at( size_t key ) const { return key < values.size() ? values[key] : defaultVal; }
+
+  void assign( size_t keyBegin, size_t keyEnd, char value )
+  {
+    if( values.size() < keyEnd ) { values.resize( keyEnd, defaultVal ); }
+    std::fill( values.begin() + std::ptrdiff_t(keyBegin), values.begin() + std::ptrdiff_t(keyEnd), value );
+  }
+
+  void shift( size_t from, size_t delta )
+  {
+    if( values.size() < from ) { return; }
+    const char gapValue { from > 0 ? values[from - 1] : defaultVal };
+    values.insert( values.begin() + std::ptrdiff_t(from), delta, gapValue );
+  }
+
+  void remove_span( size_t keyBegin, size_t keyEnd )
+  {
+    if( values.size() < keyEnd ) { values.resize( keyEnd, defaultVal ); }
+    values.erase( values.begin() + std::ptrdiff_t(keyBegin), values.begin() + std::ptrdiff_t(keyEnd) );
+  }
+};
+
+
+template<typename Map>
+bool IsCanonical( Map const& rMap, char defaultVal )
+{
+  char previous { defaultVal };
+  bool canonical { true };
+  rMap.for_each( [&]( auto const&, char value ){ canonical = canonical && value != previous; previous = value; } );
+  return canonical;
+}
+
+
+TEST(ShiftableRangeMapTests, ShiftOpensGap)
+{
+  // [ s  a  b  s ] -> [ s  a  a  a  b  s ]
+  //   0  5  10 20     0  5        13 23
+  ShiftableRangeMap<int, char> rMap {' '};
+  rMap.assign(  5, 10, 'a' );
+  rMap.assign( 10, 20, 'b' );
+
+  rMap.shift( 7, 3 );
+
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {5,'a'}, {13,'b'}, {23,' '} }) );
+
+  // a gap at a boundary takes the value before it
+  rMap.shift( 13, 2 );
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {5,'a'}, {15,'b'}, {25,' '} }) );
+
+  // gaps after the last range do not change anything
+  rMap.shift( 30, 100 );
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {5,'a'}, {15,'b'}, {25,' '} }) );
+}
+
+
+TEST(ShiftableRangeMapTests, RemoveSpanMergesNeighbours)
+{
+  // [ s  a  b  a  s ] -> [ s  a  s ]
+  //   0  5  10 15 20       0  5  15
+  ShiftableRangeMap<int, char> rMap {' '};
+  rMap.assign(  5, 20, 'a' );
+  rMap.assign( 10, 15, 'b' );
+
+  rMap.remove_span( 8, 13 );
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {5,'a'}, {8,'b'}, {10,'a'}, {15,' '} }) );
+
+  rMap.remove_span( 8, 10 );
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {5,'a'}, {13,' '} }) );
+
+  rMap.remove_span( 0, 100 );
+  ASSERT_EQ( rMap.size(), 0u );
+  ASSERT_EQ( rMap[5], ' ' );
+}
+
+
+TEST(ShiftableRangeMapTests, InvalidSpanIsIgnored)
+{
+  ShiftableRangeMap<int, char> rMap {' '};
+  rMap.assign( 5, 10, 'a' );
+
+  rMap.remove_span( 7, 7 );
+  rMap.remove_span( 8, 7 );
+  rMap.assign( 8, 7, 'b' );
+
+  ASSERT_EQ( rMap.to_map(), (std::map<int,char>{ {5,'a'}, {10,' '} }) );
+}
+
+
+TEST(ShiftableRangeMapTests, RandomEditsMatchDenseModel)
+{
+  std::mt19937 gen(39);
+  std::uniform_int_distribution<size_t> distKey( 0, 300 );
+  std::uniform_int_distribution<size_t> distLen( 1, 20 );
+  std::uniform_int_distribution<int>    distOp ( 0, 2 );
+  std::uniform_int_distribution<int>    distVal( 0, 3 );
+
+  ShiftableRangeMap<size_t, char> rMap  {'s'};
+  DenseModel                      model {'s', {}};
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const size_t keyBegin { distKey(gen) };
+    const size_t length   { distLen(gen) };
+
+    switch( distOp(gen) )
+    {
+      case 0:
+      {
+        const char value { char( 'a' + distVal(gen) ) };
+        rMap.assign ( keyBegin, keyBegin + length, value );
+        model.assign( keyBegin, keyBegin + length, value );
+        break;
+      }
+      case 1:
+        rMap.shift ( keyBegin, length );
+        model.shift( keyBegin, length );
+        break;
+      default:
+        rMap.remove_span ( keyBegin, keyBegin + length );
+        model.remove_span( keyBegin, keyBegin + length );
+        break;
+    }
+
+    ASSERT_TRUE( IsCanonical( rMap, 's' ) ) << "\nafter edit " << n << "\n";
+
+    if( n % 50 == 0 )
+    {
+      for( size_t key{0}; key < model.values.size() + 10; ++key )
+      {
+        ASSERT_EQ( rMap[key], model.at(key) ) << "\nmismatch at key " << key << " after edit " << n << "\n";
+      }
+    }
+  }
+}
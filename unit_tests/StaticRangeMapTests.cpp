@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "RangeMap/StaticRangeMap.h"
+#include <limits>
+#include <random>
+#include <vector>
+
+
+enum class CharClass { Other, Digit, Letter, Hex };
+
+constexpr auto charClasses = make_static_range_map( []{
+  return StaticRanges<char, CharClass>{ CharClass::Other, {
+    { '0', '9' + 1, CharClass::Digit  },
+    { 'a', 'z' + 1, CharClass::Letter },
+    { 'A', 'Z' + 1, CharClass::Letter },
+    { 'a', 'f' + 1, CharClass::Hex    },
+    { 'A', 'F' + 1, CharClass::Hex    },
+    { 'z', 'a',     CharClass::Hex    }, // invalid, ignored
+  } };
+} );
+
+static_assert( charClasses['5'] == CharClass::Digit  );
+static_assert( charClasses['b'] == CharClass::Hex    );
+static_assert( charClasses['g'] == CharClass::Letter );
+static_assert( charClasses['!'] == CharClass::Other  );
+static_assert( charClasses['~'] == CharClass::Other  );
+static_assert( sizeof(charClasses) == sizeof(StaticRangeMap<char, CharClass, 8>) ); // no unused boundaries
+
+
+TEST(StaticRangeMapTests, LaterRangesOverwriteEarlierOnes)
+{
+  std::vector<std::pair<char, CharClass>> boundaries;
+  charClasses.for_each( [&boundaries]( char key, CharClass value ){ boundaries.emplace_back( key, value ); } );
+
+  const std::vector<std::pair<char, CharClass>> expected {
+    { '0', CharClass::Digit }, { '9' + 1, CharClass::Other }, { 'A', CharClass::Hex    }, { 'G', CharClass::Letter },
+    { '[', CharClass::Other }, { 'a',     CharClass::Hex   }, { 'g', CharClass::Letter }, { '{', CharClass::Other  } };
+
+  ASSERT_EQ( boundaries, expected );
+  ASSERT_EQ( charClasses.size(), 8u );
+}
+
+
+TEST(StaticRangeMapTests, EmptyMapReturnsDefault)
+{
+  constexpr auto rMap = make_static_range_map( []{ return StaticRanges<int, int>{ -1, { { 5, 5, 1 } } }; } );
+
+  static_assert( rMap.size() == 0 );
+  ASSERT_EQ( rMap[std::numeric_limits<int>::min()], -1 );
+  ASSERT_EQ( rMap[5], -1 );
+}
+
+
+TEST(StaticRangeMapTests, RandomLookupsMatchRangeMap)
+{
+  std::mt19937 gen(40);
+  std::uniform_int_distribution<int> distKey( -5'000, 5'000 );
+  std::uniform_int_distribution<int> distVal( 0, 5 );
+
+  RangeMap<int, int> expected {-1};
+  for( size_t n{0}; n < 1'000; ++n )
+  {
+    expected.assign( distKey(gen), distKey(gen), distVal(gen) );
+  }
+
+  const std::vector<std::pair<int,int>> boundaries( expected.data().begin(), expected.data().end() );
+  const StaticRangeMap<int, int, 2'000> rMap { -1, boundaries };
+
+  ASSERT_EQ( rMap.size(), boundaries.size() );
+
+  for( int key{-5'010}; key <= 5'010; ++key )
+  {
+    ASSERT_EQ( rMap[key], expected[key] ) << "\nmismatch at key " << key << "\n";
+  }
+}
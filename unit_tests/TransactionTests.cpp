@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "RangeMap/TransactionalRangeMap.h"
+#include <thread>
+
+
+TEST(TransactionTests, AssignmentsAreInvisibleUntilCommit)
+{
+  TransactionalRangeMap<int, char> rMap {' '};
+
+  auto transaction = rMap.begin();
+  transaction.assign(  5, 10, 'a' );
+  transaction.assign( 20, 30, 'b' );
+
+  ASSERT_EQ( rMap[7],  ' ' );
+  ASSERT_EQ( rMap[25], ' ' );
+
+  transaction.commit();
+
+  ASSERT_EQ( rMap[7],  'a' );
+  ASSERT_EQ( rMap[25], 'b' );
+  ASSERT_EQ( rMap.snapshot().to_map(), (std::map<int,char>{ {5,'a'}, {10,' '}, {20,'b'}, {30,' '} }) );
+}
+
+
+TEST(TransactionTests, LaterAssignmentsOfTransactionWin)
+{
+  TransactionalRangeMap<int, char> rMap {' '};
+
+  auto transaction = rMap.begin();
+  transaction.assign( 0, 10, 'a' );
+  transaction.assign( 5, 15, 'b' );
+  transaction.assign( 8, 12, ' ' );
+  transaction.commit();
+
+  ASSERT_EQ( rMap.snapshot().to_map(), (std::map<int,char>{ {0,'a'}, {5,'b'}, {8,' '}, {12,'b'}, {15,' '} }) );
+}
+
+
+TEST(TransactionTests, DroppedTransactionIsDiscarded)
+{
+  TransactionalRangeMap<int, char> rMap {' '};
+
+  {
+    auto transaction = rMap.begin();
+    transaction.assign( 0, 10, 'a' );
+  }
+
+  ASSERT_EQ( rMap.snapshot().size(), 0u );
+}
+
+
+TEST(TransactionTests, ReadersNeverSeeHalfAppliedTransactions)
+{
+  TransactionalRangeMap<int, int> rMap {0};
+  std::atomic<bool> done { false };
+
+  std::thread writer( [&]()
+  {
+    for( int generation{1}; generation <= 2'000; ++generation )
+    {
+      auto transaction = rMap.begin();
+      transaction.assign(   0,  10, generation );
+      transaction.assign( 100, 110, generation );
+      transaction.assign( 200, 210, generation );
+      transaction.commit();
+    }
+    done = true;
+  });
+
+  size_t reads { 0 };
+  while( !done || reads == 0 )
+  {
+    auto snapshot = rMap.snapshot();
+    ASSERT_EQ( snapshot[5], snapshot[105] );
+    ASSERT_EQ( snapshot[5], snapshot[205] );
+    ++reads;
+  }
+
+  writer.join();
+  ASSERT_EQ( rMap[205], 2'000 );
+}
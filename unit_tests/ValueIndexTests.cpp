@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include "RangeMap/RangeMap.h"
+#include <random>
+
+
+using Ranges = std::vector<std::pair<int,int>>;
+
+
+Ranges ScanRangesOf( std::map<int, char> const& map, char value )
+{
+  Ranges out;
+  for( auto it = map.begin(); it != map.end() && std::next(it) != map.end(); ++it )
+  {
+    if( it->second == value )
+    {
+      out.emplace_back( it->first, std::next(it)->first );
+    }
+  }
+  return out;
+}
+
+
+TEST(ValueIndexTests, RangesOfValue)
+{
+  RangeMap<int, char> rMap {' '};
+  rMap.assign( 0, 5, 'a' );
+  rMap.enable_value_index(); // built from the existing ranges
+  rMap.assign( 10, 15, 'a' );
+  rMap.assign( 12, 20, 'b' );
+
+  ASSERT_EQ( rMap.ranges_of( 'a' ), (Ranges{ {0,5}, {10,12} }) );
+  ASSERT_EQ( rMap.ranges_of( 'b' ), (Ranges{ {12,20} }) );
+  ASSERT_EQ( rMap.ranges_of( ' ' ), (Ranges{ {5,10} }) );
+  ASSERT_EQ( rMap.ranges_of( 'c' ), (Ranges{}) );
+}
+
+
+TEST(ValueIndexTests, ReplaceValue)
+{
+  RangeMap<int, char> rMap {' '};
+  rMap.enable_value_index();
+  rMap.assign(  0,  5, 'a' );
+  rMap.assign(  5, 10, 'b' );
+  rMap.assign( 10, 15, 'a' );
+
+  // revoking 'a' merges its ranges with the neighbouring default value
+  rMap.replace_value( 'a', ' ' );
+  ASSERT_EQ( rMap.data(), (std::map<int,char>{ {5,'b'}, {10,' '} }) );
+  ASSERT_EQ( rMap.ranges_of( 'a' ), (Ranges{}) );
+
+  rMap.replace_value( 'b', 'c' );
+  ASSERT_EQ( rMap.data(), (std::map<int,char>{ {5,'c'}, {10,' '} }) );
+  ASSERT_EQ( rMap.ranges_of( 'c' ), (Ranges{ {5,10} }) );
+}
+
+
+TEST(ValueIndexTests, CopyHasItsOwnIndex)
+{
+  RangeMap<int, char> rMap {' '};
+  rMap.enable_value_index();
+  rMap.assign( 0, 5, 'a' );
+
+  RangeMap<int, char> copy { rMap };
+  rMap.assign( 0, 10, 'b' );
+
+  ASSERT_EQ( copy.ranges_of( 'a' ), (Ranges{ {0,5} }) );
+  ASSERT_EQ( rMap.ranges_of( 'a' ), (Ranges{}) );
+}
+
+
+TEST(ValueIndexTests, RandomAgainstScan)
+{
+  std::mt19937 gen(31);
+  std::uniform_int_distribution<> distKey(-500, 500);
+  std::uniform_int_distribution<> distVal(0, 4);
+  std::uniform_int_distribution<> distRsize(1, 60);
+  std::uniform_int_distribution<> distOp(0, 4);
+
+  RangeMap<int, char> leader   {'a'};
+  RangeMap<int, char> follower {'a'};
+  leader.enable_change_log();
+  leader.enable_value_index();
+  follower.enable_value_index();
+
+  for( size_t n{0}; n < 5'000; ++n )
+  {
+    const int  pos   { distKey(gen) };
+    const int  end   { pos + distRsize(gen) };
+    const char value ( char('a' + distVal(gen)) );
+
+    switch( distOp(gen) )
+    {
+      case 0:  leader.apply( pos, end, []( char& v ){ v = char('a' + (v - 'a' + 1) % 5); } ); break;
+      case 1:  leader.replace_value( value, char('a' + distVal(gen)) );                       break;
+      default: leader.assign( pos, end, value );                                              break;
+    }
+
+    ASSERT_TRUE( follower.apply_delta( *leader.changes_since( follower.version() ) ) );
+
+    for( char v{'a'}; v < 'f'; ++v )
+    {
+      ASSERT_EQ( leader.ranges_of( v ),   ScanRangesOf( leader.data(), v ) )   << "\nmismatch after operation " << n << "\n";
+      ASSERT_EQ( follower.ranges_of( v ), ScanRangesOf( follower.data(), v ) ) << "\nfollower mismatch after operation " << n << "\n";
+    }
+  }
+}